@@ -0,0 +1,148 @@
+/**
+ * Bulk build and parallel scan benchmark
+ *
+ * Builds a btree from random keys by inserting them one at a time, by inserting them in batches of
+ * 10000 with insert_batch, by sorting them and bulk loading with assign_sorted, and with assign_parallel
+ * on an increasing number of threads. Ascending keys, as an ingest of timestamps would deliver, are
+ * also inserted one at a time and in batches. The built tree is then summed with an iterator loop and
+ * with parallel_for_each on the same thread counts.
+ *
+ * Usage: ./bench_build [keys] [max threads]
+ **/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+//Keys per insert_batch call
+const size_t kBatch = 10000;
+
+/**
+ * Runs fn once and returns the time it took in milliseconds.
+ **/
+template <typename F>
+double time(F fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto finish = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+/**
+ * A running total which threads add to without sharing a cache line, unless their ids collide.
+ **/
+struct spread_sum {
+  struct alignas(64) slot {
+    std::atomic<long> value{0};
+  };
+
+  slot slots[64];
+
+  void add(long value) {
+    slots[std::hash<std::thread::id>()(std::this_thread::get_id()) % 64].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  long total() const {
+    long sum = 0;
+    for (const slot& s : slots)
+      sum += s.value.load(std::memory_order_relaxed);
+
+    return sum;
+  }
+};
+
+void report(const std::string& name, double ms) {
+  cout << std::left << std::setw(28) << name << std::fixed << std::setprecision(1) << ms << " ms" << endl;
+}
+
+}  // namespace close
+
+int main(int argc, char *argv[]) {
+  size_t keys = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+  size_t maxThreads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : btree_thread_count(0);
+
+  std::mt19937_64 gen(20);
+  std::vector<long> values(keys);
+  for (long& value : values)
+    value = static_cast<long>(gen() >> 1);
+
+  cout << "keys: " << keys << ", hardware threads: " << std::thread::hardware_concurrency() << endl;
+
+  btree<long> tree;
+  report("insert", time([&]() {
+    for (long value : values)
+      tree.insert(value);
+  }));
+
+  btree<long> batched;
+  report("insert_batch", time([&]() {
+    for (size_t i = 0; i < keys; i += kBatch)
+      batched.insert_batch(values.begin() + i, values.begin() + std::min(i + kBatch, keys));
+  }));
+
+  std::vector<long> ascending(keys);
+  for (size_t i = 0; i < keys; ++i)
+    ascending[i] = static_cast<long>(i);
+
+  btree<long> appended;
+  report("insert (ascending)", time([&]() {
+    for (long value : ascending)
+      appended.insert(value);
+  }));
+
+  appended.clear();
+  report("insert_batch (ascending)", time([&]() {
+    for (size_t i = 0; i < keys; i += kBatch)
+      appended.insert_batch(ascending.begin() + i, ascending.begin() + std::min(i + kBatch, keys));
+  }));
+
+  if (batched.size() != tree.size() || appended.size() != keys)
+    cout << "insert_batch lost elements" << endl;
+
+  report("sort + assign_sorted", time([&]() {
+    std::vector<long> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    tree.assign_sorted(sorted.begin(), sorted.end());
+  }));
+
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    report("assign_parallel (" + std::to_string(threads) + ")", time([&]() {
+      tree.assign_parallel(values.begin(), values.end(), threads);
+    }));
+  }
+
+  long expected = 0;
+  report("scan", time([&]() {
+    for (auto it = tree.cbegin(); it != tree.cend(); ++it)
+      expected += *it;
+  }));
+
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    spread_sum sum;
+
+    report("parallel_for_each (" + std::to_string(threads) + ")", time([&]() {
+      parallel_for_each(tree, [&](long value) { sum.add(value); }, threads);
+    }));
+
+    if (sum.total() != expected)
+      cout << "parallel_for_each missed elements" << endl;
+  }
+
+  return 0;
+}
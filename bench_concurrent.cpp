@@ -0,0 +1,133 @@
+/**
+ * Concurrent read/write mix benchmark
+ *
+ * Runs a mix of searches, insertions and removals of random keys from an increasing number of threads
+ * against a concurrent_btree, and against a btree behind a single mutex as it would otherwise be shared,
+ * reporting total throughput for each thread count. Both trees start holding half of the key range.
+ *
+ * Usage: ./bench_concurrent [keys] [operations per thread] [percent searches] [max threads]
+ **/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "btree.h"
+#include "concurrent_btree.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+/**
+ * A btree with every operation serialised by one mutex.
+ **/
+class locked_btree {
+ public:
+  bool insert(long key) {
+    std::lock_guard<std::mutex> guard(mutex);
+    return tree.insert(key).second;
+  }
+
+  bool erase(long key) {
+    std::lock_guard<std::mutex> guard(mutex);
+    return tree.erase(key) == 1;
+  }
+
+  bool contains(long key) {
+    std::lock_guard<std::mutex> guard(mutex);
+    return tree.contains(key);
+  }
+
+ private:
+  std::mutex mutex;
+  btree<long> tree;
+};
+
+/**
+ * Runs operations on tree from the given number of threads at once and returns the
+ * total throughput in millions of operations per second.
+ **/
+template <typename Tree>
+double run(Tree& tree, size_t threads, size_t keys, size_t operations, unsigned searchPercent, size_t& checksum) {
+  std::vector<std::thread> workers;
+  std::vector<size_t> hits(threads);
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&tree, &hits, t, keys, operations, searchPercent] {
+      std::mt19937_64 rng(t + 1);
+      size_t found = 0;
+
+      for (size_t i = 0; i < operations; ++i) {
+        long key = static_cast<long>(rng() % keys);
+        unsigned op = static_cast<unsigned>(rng() % 100);
+
+        //Writes are split evenly between insertions and removals, so the tree stays around half full
+        if (op < searchPercent)
+          found += tree.contains(key);
+        else if (op % 2)
+          found += tree.insert(key);
+        else
+          found += tree.erase(key);
+      }
+
+      hits[t] = found;
+    });
+  }
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  auto finish = std::chrono::steady_clock::now();
+
+  for (size_t found : hits)
+    checksum += found;
+
+  return threads * operations / std::chrono::duration<double, std::micro>(finish - start).count();
+}
+
+}  // namespace close
+
+int main(int argc, char *argv[]) {
+  size_t keys = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t operations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+  unsigned searchPercent = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 90;
+  size_t maxThreads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+
+  size_t checksum = 0;
+
+  cout << "keys: " << keys << ", operations per thread: " << operations << ", searches: " << searchPercent << "%" << endl;
+  cout << std::left << std::setw(10) << "threads" << std::setw(24) << "concurrent_btree Mops/s" << "btree + mutex Mops/s" << endl;
+
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    concurrent_btree<long> concurrent;
+    locked_btree locked;
+
+    for (size_t key = 0; key < keys; key += 2) {
+      concurrent.insert(static_cast<long>(key));
+      locked.insert(static_cast<long>(key));
+    }
+
+    double concurrentRate = run(concurrent, threads, keys, operations, searchPercent, checksum);
+    double lockedRate = run(locked, threads, keys, operations, searchPercent, checksum);
+
+    cout << std::left << std::setw(10) << threads << std::setw(24) << concurrentRate << lockedRate << endl;
+
+    //Always finish with the full thread count
+    if (threads < maxThreads && threads * 2 > maxThreads)
+      threads = maxThreads / 2;
+  }
+
+  cout << "checksum: " << checksum << endl;
+
+  return 0;
+}
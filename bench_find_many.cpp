@@ -0,0 +1,117 @@
+/**
+ * Batched lookup benchmark
+ *
+ * Looks up random keys, half of them present, in btrees of increasing size and several node sizes,
+ * either one at a time with find or in batches of 256 with find_many and contains_many, as a request
+ * handler looking up many keys at once would. Interleaving the descents of a batch pays off once the
+ * tree no longer fits in the last level cache, which the default largest size of 10M keys exceeds.
+ *
+ * Usage: ./bench_find_many [largest tree] [lookups]
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+//Keys per batch handed to find_many
+const size_t kBatch = 256;
+
+/**
+ * Runs fn once and returns the time it took per lookup in nanoseconds.
+ **/
+template <typename F>
+double time(size_t lookups, F fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto finish = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(finish - start).count() / lookups;
+}
+
+template <typename Tree>
+void benchTree(const std::string& name, Tree& tree, const std::vector<long>& probes, size_t& checksum) {
+  typedef typename Tree::const_iterator const_iterator;
+  const Tree& view = tree;
+
+  double single = time(probes.size(), [&]() {
+    for (long probe : probes)
+      checksum += view.find(probe) != view.end();
+  });
+
+  std::vector<const_iterator> found(kBatch);
+  double batched = time(probes.size(), [&]() {
+    for (size_t i = 0; i < probes.size(); i += kBatch) {
+      size_t n = std::min(kBatch, probes.size() - i);
+      view.find_many(probes.begin() + i, probes.begin() + i + n, found.begin());
+
+      for (size_t j = 0; j < n; ++j)
+        checksum += found[j] != view.end();
+    }
+  });
+
+  std::vector<char> present(kBatch);
+  double contained = time(probes.size(), [&]() {
+    for (size_t i = 0; i < probes.size(); i += kBatch) {
+      size_t n = std::min(kBatch, probes.size() - i);
+      view.contains_many(probes.begin() + i, probes.begin() + i + n, present.begin());
+
+      for (size_t j = 0; j < n; ++j)
+        checksum += present[j];
+    }
+  });
+
+  cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+       << std::setw(12) << single << std::setw(16) << batched << std::setw(20) << contained
+       << std::setw(10) << single / batched << "x" << endl;
+}
+
+}  // namespace close
+
+int main(int argc, char *argv[]) {
+  size_t largest = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+  size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000;
+
+  std::mt19937_64 rng(24);
+  size_t checksum = 0;
+
+  for (size_t size = std::min<size_t>(100000, largest); size <= largest; size *= 10) {
+    //Even keys are present, so odd probes miss
+    std::vector<long> keys(size);
+    for (size_t i = 0; i < size; ++i)
+      keys[i] = static_cast<long>(i) * 2;
+
+    std::vector<long> probes(lookups);
+    for (long& probe : probes)
+      probe = static_cast<long>(rng() % (size * 2));
+
+    cout << "keys: " << size << endl;
+    cout << std::left << std::setw(20) << "tree" << std::right << std::setw(12) << "find ns" << std::setw(16)
+         << "find_many ns" << std::setw(20) << "contains_many ns" << std::setw(11) << "speedup" << endl;
+
+    for (size_t nodeSize : {16, 64}) {
+      btree<long> tree(keys.begin(), keys.end(), nodeSize);
+      benchTree("btree (" + std::to_string(nodeSize) + ")", tree, probes, checksum);
+    }
+
+    fixed_btree<long> fixed(keys.begin(), keys.end());
+    benchTree("fixed_btree", fixed, probes, checksum);
+
+    cout << endl;
+  }
+
+  std::cerr << "checksum: " << checksum << endl;
+
+  return 0;
+}
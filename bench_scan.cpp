@@ -0,0 +1,96 @@
+/**
+ * Full scan benchmark
+ *
+ * Measures the time taken to visit every element of a btree and a bplus_tree in order,
+ * compared against iterating a std::vector and a std::set holding the same elements.
+ *
+ * Usage: ./bench_scan [elements] [repetitions]
+ **/
+
+#include <chrono>
+#include <iomanip>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "btree.h"
+#include "bplus_tree.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+/**
+ * Runs a full scan repeatedly and returns the best time per element in nanoseconds.
+ * Elements are summed so the scan cannot be optimised away.
+ **/
+template <typename Container>
+double scan(const Container& container, size_t elements, size_t repetitions, long& checksum) {
+  double best = 0;
+
+  for (size_t r = 0; r < repetitions; ++r) {
+    auto start = std::chrono::steady_clock::now();
+
+    long sum = 0;
+    for (auto it = container.begin(); it != container.end(); ++it)
+      sum += *it;
+
+    auto finish = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count() / elements;
+
+    if (r == 0 || ns < best)
+      best = ns;
+
+    checksum += sum;
+  }
+
+  return best;
+}
+
+}  // namespace close
+
+int main(int argc, char *argv[]) {
+  size_t elements = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t repetitions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+
+  //Insert in a scrambled order so nodes are spread through memory as they would be in use
+  std::vector<long> values;
+  for (size_t i = 0; i < elements; ++i)
+    values.push_back(static_cast<long>(i * 2654435761u % elements));
+
+  //Scrambling may repeat values when elements shares a factor with the multiplier, so count what is left
+  std::set<long> set(values.begin(), values.end());
+  std::vector<long> sorted(set.begin(), set.end());
+  elements = sorted.size();
+
+  long checksum = 0;
+
+  cout << "elements: " << elements << ", best of " << repetitions << " scans" << endl;
+  cout << std::left << std::setw(18) << "std::vector" << scan(sorted, elements, repetitions, checksum) << " ns/element" << endl;
+  cout << std::left << std::setw(18) << "std::set" << scan(set, elements, repetitions, checksum) << " ns/element" << endl;
+
+  for (size_t nodeSize : {4, 16, 40, 128}) {
+    btree<long> tree(nodeSize);
+    for (long value : values)
+      tree.insert(value);
+
+    cout << std::left << std::setw(18) << "btree (" + std::to_string(nodeSize) + ")"
+         << scan(tree, elements, repetitions, checksum) << " ns/element" << endl;
+  }
+
+  for (size_t nodeSize : {4, 16, 40, 128}) {
+    bplus_tree<long> tree(nodeSize);
+    for (long value : values)
+      tree.insert(value);
+
+    cout << std::left << std::setw(18) << "bplus_tree (" + std::to_string(nodeSize) + ")"
+         << scan(tree, elements, repetitions, checksum) << " ns/element" << endl;
+  }
+
+  cout << "checksum: " << checksum << endl;
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * Node search microbenchmark
+ *
+ * Times a single node's key search for int, long and double keys across node sizes, comparing
+ * std::lower_bound's binary search, a scalar linear scan and btree_lower_bound, which uses
+ * vector compares when this build enables them (compile with -mavx2 or -march=native for AVX2).
+ *
+ * Usage: ./bench_search [searches]
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree_search.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+//Enough nodes of each size that searches are not all served from the L1 cache
+const size_t kKeys = 1 << 16;
+
+/**
+ * Times search over every probe, each probe searching the node its index selects,
+ * and returns the time per search in nanoseconds.
+ **/
+template <typename T, typename Search>
+double timeSearch(const std::vector<T>& keys, size_t n, const std::vector<T>& probes, Search search, size_t& checksum) {
+  size_t nodes = keys.size() / n;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < probes.size(); ++i) {
+    checksum += search(keys.data() + (i % nodes) * n, n, probes[i]);
+  }
+
+  auto finish = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(finish - start).count() / probes.size();
+}
+
+template <typename T>
+void benchType(const std::string& name, size_t searches, size_t& checksum) {
+  std::mt19937 rng(6771);
+
+  for (size_t n : {8, 16, 32, 40, 64, 128, 256}) {
+    //Each node holds n sorted keys spread across the probe range
+    std::vector<T> keys(kKeys / n * n);
+    std::uniform_int_distribution<int> value(0, 1000000);
+
+    for (size_t node = 0; node < keys.size(); node += n) {
+      for (size_t i = 0; i < n; ++i)
+        keys[node + i] = static_cast<T>(value(rng));
+      std::sort(keys.begin() + node, keys.begin() + node + n);
+    }
+
+    std::vector<T> probes(searches);
+    for (T& probe : probes)
+      probe = static_cast<T>(value(rng));
+
+    double binary = timeSearch(keys, n, probes, [](const T *k, size_t count, T elem) {
+      return size_t(std::lower_bound(k, k + count, elem) - k);
+    }, checksum);
+
+    double linear = timeSearch(keys, n, probes, [](const T *k, size_t count, T elem) {
+      size_t i = 0;
+      while (i < count && k[i] < elem)
+        ++i;
+      return i;
+    }, checksum);
+
+    double node = timeSearch(keys, n, probes, [](const T *k, size_t count, T elem) {
+      return btree_lower_bound(k, count, elem, std::less<T>());
+    }, checksum);
+
+    cout << std::left << std::setw(8) << name << std::setw(6) << n << std::fixed << std::setprecision(2)
+         << std::setw(12) << binary << std::setw(12) << linear << std::setw(12) << node << endl;
+  }
+}
+
+}  // namespace close
+
+int main(int argc, char *argv[]) {
+  size_t searches = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+  size_t checksum = 0;
+
+  cout << "vector search " << (BTREE_SIMD_SEARCH ? "enabled" : "disabled")
+#if defined(__AVX2__)
+       << " (AVX2)"
+#elif defined(__SSE2__)
+       << " (SSE2)"
+#endif
+       << ", ns per search" << endl;
+  cout << std::left << std::setw(8) << "type" << std::setw(6) << "keys"
+       << std::setw(12) << "binary" << std::setw(12) << "linear" << std::setw(12) << "node" << endl;
+
+  benchType<int>("int", searches, checksum);
+  benchType<long>("long", searches, checksum);
+  benchType<double>("double", searches, checksum);
+
+  cout << "checksum: " << checksum << endl;
+
+  return 0;
+}
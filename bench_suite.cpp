@@ -0,0 +1,362 @@
+/**
+ * Benchmark suite
+ *
+ * Measures btree<long> and btree<std::string> at several node sizes against std::set holding the
+ * same elements, over the workloads below, and writes one CSV row per container and workload:
+ *
+ *   insert      inserting every element, in random order, into an empty container
+ *   find_hit    finding every element, in random order
+ *   find_miss   finding as many elements which are not present
+ *   scan        iterating over every element in order
+ *   range_scan  positioning at a random element with lower_bound and iterating over the next 100
+ *   copy        copy constructing the whole container
+ *   destroy     destroying that copy
+ *
+ * ns_per_op is the best time of the repetitions divided by the operations in a run, each operation
+ * being an element except for range_scan, where it is a whole range. bytes_per_element is the
+ * container's memory, counted through its allocator once loaded, divided by its elements. Strings
+ * own their characters separately, so only their std::string objects are counted.
+ *
+ * cache_misses_per_op and branch_misses_per_op come from the hardware counters of the same run as
+ * ns_per_op, read with perf_event_open on Linux. They are left empty where the counters cannot be
+ * opened, such as on other platforms, in most containers, or when /proc/sys/kernel/perf_event_paranoid
+ * is above 2.
+ *
+ * Strings are the words of twl.txt, each repeated with numbered suffixes until there are enough.
+ *
+ * Usage: ./bench_suite [elements] [repetitions] [word list] > results.csv
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "btree.h"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+//Bytes currently allocated through every counting_allocator
+size_t allocatedBytes = 0;
+
+/**
+ * An allocator which counts the bytes it hands out, so containers of any type can be measured alike.
+ **/
+template <typename T>
+struct counting_allocator {
+  typedef T value_type;
+
+  counting_allocator() = default;
+  template <typename U>
+  counting_allocator(const counting_allocator<U>&) {}
+
+  T* allocate(size_t n) {
+    allocatedBytes += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, size_t n) {
+    allocatedBytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(const counting_allocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const counting_allocator<U>&) const { return false; }
+};
+
+//What scans add to the checksum for each element, so they read it
+size_t weigh(long value) { return static_cast<size_t>(value); }
+size_t weigh(const std::string& value) { return value.size(); }
+
+//Elements in each range_scan operation
+const size_t kRangeLength = 100;
+
+/**
+ * Cache and branch miss counters of the calling thread, opened with perf_event_open. Only user space is
+ * counted, which unprivileged processes are allowed by default. Where the counters cannot be opened,
+ * available() is false and nothing is counted.
+ **/
+class perf_counters {
+ public:
+  perf_counters() {
+#ifdef __linux__
+    const uint64_t events[kEvents] = {PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    for (size_t i = 0; i < kEvents; ++i) {
+      perf_event_attr attr = {};
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = events[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+  }
+
+  ~perf_counters() {
+#ifdef __linux__
+    for (int fd : fds) {
+      if (fd >= 0)
+        close(fd);
+    }
+#endif
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  bool available() const { return fds[0] >= 0 && fds[1] >= 0; }
+
+  void start() {
+#ifdef __linux__
+    for (int fd : fds) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  //Stop counting and read the counts since start(), cache misses first
+  void stop(uint64_t counts[]) {
+    for (size_t i = 0; i < kEvents; ++i) {
+      counts[i] = 0;
+#ifdef __linux__
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fds[i], &counts[i], sizeof(counts[i])) != sizeof(counts[i]))
+        counts[i] = 0;
+#endif
+    }
+  }
+
+ private:
+  static const size_t kEvents = 2;
+  int fds[kEvents] = {-1, -1};
+};
+
+//The counters every measurement is taken with
+perf_counters& perf() {
+  static perf_counters counters;
+  return counters;
+}
+
+/**
+ * The time and hardware counts of a run, the counts left negative when unavailable.
+ **/
+struct measurement {
+  double ns = 0;
+  double cacheMisses = -1;
+  double branchMisses = -1;
+};
+
+/**
+ * Runs fn repetitions times and returns the measurement of the fastest run.
+ **/
+measurement best(size_t repetitions, const std::function<void()>& fn) {
+  measurement fastest;
+
+  for (size_t r = 0; r < repetitions; ++r) {
+    uint64_t counts[2];
+
+    if (perf().available())
+      perf().start();
+
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto finish = std::chrono::steady_clock::now();
+
+    if (perf().available())
+      perf().stop(counts);
+
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count();
+
+    if (r == 0 || ns < fastest.ns) {
+      fastest.ns = ns;
+
+      if (perf().available()) {
+        fastest.cacheMisses = static_cast<double>(counts[0]);
+        fastest.branchMisses = static_cast<double>(counts[1]);
+      }
+    }
+  }
+
+  return fastest;
+}
+
+/**
+ * Writes a CSV row for a measurement of ops operations, leaving the counts empty when unavailable.
+ **/
+void row(const std::string& container, const std::string& element, size_t fanout, const std::string& workload,
+         size_t elements, const measurement& m, size_t ops, double bytesPerElement) {
+  cout << container << ',' << element << ',' << fanout << ',' << workload << ',' << elements << ','
+       << m.ns / ops << ',' << bytesPerElement << ',';
+
+  if (m.cacheMisses >= 0)
+    cout << m.cacheMisses / ops << ',' << m.branchMisses / ops;
+  else
+    cout << ',';
+
+  cout << endl;
+}
+
+/**
+ * Runs every workload on containers made by make, which holds the elements of keys once loaded.
+ * misses are elements which are never present, starts are the elements range scans start from.
+ **/
+template <typename Container, typename T>
+void run(const std::string& container, const std::string& element, size_t fanout, std::function<Container*()> make,
+         const std::vector<T>& keys, const std::vector<T>& misses, const std::vector<T>& starts, size_t repetitions, size_t& checksum) {
+  size_t n = keys.size();
+
+  measurement insert = best(repetitions, [&]() {
+    std::unique_ptr<Container> fresh(make());
+    for (const auto& key : keys)
+      fresh->insert(key);
+    checksum += fresh->find(keys.front()) != fresh->end();
+  });
+
+  //The container every other workload reads, and its memory once loaded
+  size_t before = allocatedBytes;
+  std::unique_ptr<Container> loaded(make());
+  for (const auto& key : keys)
+    loaded->insert(key);
+  double bytes = static_cast<double>(allocatedBytes - before) / n;
+
+  measurement findHit = best(repetitions, [&]() {
+    for (const auto& key : keys)
+      checksum += loaded->find(key) != loaded->end();
+  });
+
+  measurement findMiss = best(repetitions, [&]() {
+    for (const auto& key : misses)
+      checksum += loaded->find(key) != loaded->end();
+  });
+
+  measurement scan = best(repetitions, [&]() {
+    for (auto it = loaded->begin(); it != loaded->end(); ++it)
+      checksum += weigh(*it);
+  });
+
+  measurement rangeScan = best(repetitions, [&]() {
+    for (const auto& start : starts) {
+      auto it = loaded->lower_bound(start);
+      for (size_t i = 0; i < kRangeLength && it != loaded->end(); ++i, ++it)
+        checksum += weigh(*it);
+    }
+  });
+
+  //Each copy is destroyed in a run of its own, so both are timed on their own
+  measurement copy, destroy;
+  for (size_t r = 0; r < repetitions; ++r) {
+    std::unique_ptr<Container> copied;
+
+    measurement copyRun = best(1, [&]() { copied.reset(new Container(*loaded)); });
+    measurement destroyRun = best(1, [&]() { copied.reset(); });
+
+    if (r == 0 || copyRun.ns < copy.ns)
+      copy = copyRun;
+    if (r == 0 || destroyRun.ns < destroy.ns)
+      destroy = destroyRun;
+  }
+
+  row(container, element, fanout, "insert", n, insert, n, bytes);
+  row(container, element, fanout, "find_hit", n, findHit, n, bytes);
+  row(container, element, fanout, "find_miss", n, findMiss, misses.size(), bytes);
+  row(container, element, fanout, "scan", n, scan, n, bytes);
+  row(container, element, fanout, "range_scan", n, rangeScan, starts.size(), bytes);
+  row(container, element, fanout, "copy", n, copy, n, bytes);
+  row(container, element, fanout, "destroy", n, destroy, n, bytes);
+}
+
+/**
+ * Runs the workloads for std::set and a btree of each node size over the same elements.
+ **/
+template <typename T>
+void runAll(const std::string& element, const std::vector<T>& keys, const std::vector<T>& misses, size_t repetitions, size_t& checksum) {
+  typedef std::set<T, std::less<T>, counting_allocator<T> > set_type;
+  typedef btree<T, std::less<T>, counting_allocator<T> > btree_type;
+
+  std::mt19937 rng(22);
+  std::vector<T> starts;
+  for (size_t i = 0; i < std::max<size_t>(keys.size() / kRangeLength, 1); ++i)
+    starts.push_back(keys[rng() % keys.size()]);
+
+  run<set_type>("std::set", element, 0, []() { return new set_type(); }, keys, misses, starts, repetitions, checksum);
+
+  for (size_t fanout : {4, 16, 40, 128}) {
+    run<btree_type>("btree", element, fanout, [fanout]() { return new btree_type(fanout); }, keys, misses, starts, repetitions, checksum);
+  }
+}
+
+}  // namespace close
+
+int main(int argc, char *argv[]) {
+  size_t elements = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t repetitions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+  std::string wordList = argc > 3 ? argv[3] : "twl.txt";
+
+  std::mt19937 rng(6771);
+
+  //Distinct even numbers in random order, so odd numbers always miss
+  std::vector<long> longs, longMisses;
+  for (size_t i = 0; i < elements; ++i) {
+    longs.push_back(static_cast<long>(i) * 2);
+    longMisses.push_back(static_cast<long>(i) * 2 + 1);
+  }
+  std::shuffle(longs.begin(), longs.end(), rng);
+  std::shuffle(longMisses.begin(), longMisses.end(), rng);
+
+  std::vector<std::string> words;
+  std::ifstream in(wordList);
+  for (std::string word; in >> word;)
+    words.push_back(word);
+
+  if (words.empty()) {
+    std::cerr << "could not read any words from " << wordList << endl;
+    return 1;
+  }
+
+  //Numbered copies of the words, with a '-' in place of the number always missing
+  std::vector<std::string> strings, stringMisses;
+  for (size_t i = 0; i < elements; ++i) {
+    const std::string& word = words[i % words.size()];
+    size_t copy = i / words.size();
+
+    strings.push_back(copy == 0 ? word : word + std::to_string(copy));
+    stringMisses.push_back(word + "-" + std::to_string(copy));
+  }
+  std::shuffle(strings.begin(), strings.end(), rng);
+  std::shuffle(stringMisses.begin(), stringMisses.end(), rng);
+
+  size_t checksum = 0;
+
+  cout << "container,element,fanout,workload,elements,ns_per_op,bytes_per_element,cache_misses_per_op,branch_misses_per_op" << endl;
+  runAll("long", longs, longMisses, repetitions, checksum);
+  runAll("string", strings, stringMisses, repetitions, checksum);
+
+  std::cerr << "checksum: " << checksum << endl;
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef BPLUS_ITERATOR_H
+#define BPLUS_ITERATOR_H
+
+#include <iterator>
+#include <type_traits>
+
+/**
+ * bplus_iterator and const_bplus_iterator implementations.
+ *
+ * Will allow in-order (from lowest to highest) traversal through a bplus_tree.
+ * Every element lives in a leaf and leaves are linked to their neighbours, so the iterator
+ * only stores the current leaf 'node' and the slot 'pos' within its key array, and never
+ * visits internal nodes. The end() position is the slot one past the last key of the last leaf.
+ *
+*/
+
+template <typename T, typename Compare, typename Alloc> class bplus_tree;
+template <typename T> struct bplus_node;
+template <typename T> class const_bplus_iterator;
+
+template <typename T>
+class bplus_iterator {
+public:
+  friend class const_bplus_iterator<T>;
+  template <typename, typename, typename> friend class bplus_tree;
+
+  typedef ptrdiff_t difference_type;
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef T* pointer;
+  typedef T& reference;
+
+  bool operator==(const bplus_iterator<T>&) const;
+  bool operator!=(const bplus_iterator<T>& other) const { return !operator==(other); }
+
+  reference operator*() const;
+  pointer operator->() const { return &(operator*()); }
+  bplus_iterator<T>& operator++(); //preinc
+  bplus_iterator<T> operator++(int); //postinc
+  bplus_iterator<T>& operator--(); //predec
+  bplus_iterator<T> operator--(int); //postdec
+
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  bplus_iterator() : node(nullptr), pos(0) {}
+  bplus_iterator(bplus_node<T> *n, size_t pos)
+    : node(n), pos(pos) {}
+
+private:
+  //Store a current leaf as well as a slot within its key array
+  bplus_node<T> *node;
+  size_t pos;
+};
+
+template <typename T>
+class const_bplus_iterator {
+public:
+  typedef ptrdiff_t difference_type;
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef const T* pointer;
+  typedef const T& reference;
+
+  bool operator==(const const_bplus_iterator&) const;
+  bool operator!=(const const_bplus_iterator& other) const { return !operator==(other); }
+
+  bool operator==(const bplus_iterator<T>&) const;
+  bool operator!=(const bplus_iterator<T>& other) const { return !operator==(other); }
+
+  reference operator*() const;
+  pointer operator->() const { return &(operator*()); }
+  const_bplus_iterator& operator++(); //preinc
+  const_bplus_iterator operator++(int);  //postinc
+  const_bplus_iterator& operator--(); //predec
+  const_bplus_iterator operator--(int);  //post dec
+
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  const_bplus_iterator() : node(nullptr), pos(0) {}
+
+  //Allow conversion of bplus_iterator to const_bplus_iterator
+  const_bplus_iterator(const bplus_iterator<T>& it) : const_bplus_iterator(it.node, it.pos) {};
+
+  const_bplus_iterator(const bplus_node<T> *n, size_t pos)
+    : node(n), pos(pos) {}
+
+private:
+  //Store a current leaf as well as a slot within its key array
+  const bplus_node<T> *node;
+  size_t pos;
+};
+
+static_assert(std::is_trivially_copyable<bplus_iterator<int> >::value, "bplus_iterator must be trivially copyable");
+static_assert(std::is_trivially_copyable<const_bplus_iterator<int> >::value, "const_bplus_iterator must be trivially copyable");
+
+#include "bplus_iterator.tem"
+
+#endif
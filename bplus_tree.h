@@ -0,0 +1,268 @@
+/**
+ * The bplus_tree is a B+-tree variant of the btree, offering the
+ * same ordered set of unique client elements. All elements are
+ * stored in the leaves, which are linked to their neighbours in
+ * order, while internal nodes only hold separator keys used to
+ * route searches down to the right leaf.
+ *
+ * Scans from begin() to end() (or rbegin() to rend()) are therefore a
+ * linear walk over the leaves' contiguous arrays which never revisits
+ * internal nodes, suiting workloads dominated by sequential and range scans.
+ */
+
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include <iostream>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+
+//Include our nodes and iterators
+#include "btree_node.h"
+#include "btree_iterator.h"
+#include "bplus_iterator.h"
+#include "btree_search.h"
+
+//Add declarations for non-template friends
+template <typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T> > class bplus_tree;
+template <typename T, typename Compare, typename Alloc> std::ostream& operator<<(std::ostream& os, const bplus_tree<T, Compare, Alloc>& tree);
+
+/*
+ * T is the element type, ordered by Compare. As with btree, all node memory comes
+ * from a pool which takes its slabs from an allocator of type Alloc.
+*/
+template <typename T, typename Compare, typename Alloc>
+class bplus_tree {
+ public:
+  /**
+   * Constructs an empty bplus_tree. Elements have the same
+   * requirements as those of a btree.
+   *
+   * Both leaves and internal nodes hold up to maxNodeElems keys,
+   * which is rounded up to two.
+   *
+   * @param maxNodeElems the maximum number of keys
+   *        that can be stored in each node
+   * @param comp the ordering used to compare elements
+   * @param alloc the allocator node slabs are obtained from
+   */
+  bplus_tree(size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc());
+
+  /**
+   * Copy constructor
+   * Creates a new tree as a copy of original.
+   *
+   * @param original a const lvalue reference to a bplus_tree object
+   */
+  bplus_tree(const bplus_tree<T, Compare, Alloc>& original);
+
+  /**
+   * Move constructor
+   * Creates a new tree by "stealing" from original.
+   *
+   * @param original an rvalue reference to a bplus_tree object
+   */
+  bplus_tree(bplus_tree<T, Compare, Alloc>&& original);
+
+  /**
+   * Copy assignment
+   * Replaces the contents of this object with a copy of rhs.
+   *
+   * @param rhs a const lvalue reference to a bplus_tree object
+   */
+  bplus_tree<T, Compare, Alloc>& operator=(const bplus_tree<T, Compare, Alloc>& rhs);
+
+  /**
+   * Move assignment
+   * Replaces the contents of this object with the "stolen"
+   * contents of rhs.
+   *
+   * @param rhs an rvalue reference to a bplus_tree object
+   */
+  bplus_tree<T, Compare, Alloc>& operator=(bplus_tree<T, Compare, Alloc>&& rhs);
+
+  /**
+   * Puts the elements of the tree onto the output stream os in order.
+   * Separator keys in internal nodes only repeat leaf values, so they
+   * are not printed. Elements are separated by space. Should not output any newlines.
+   *
+   * @param os a reference to a C++ output stream
+   * @param tree a const reference to a bplus_tree object
+   * @return a reference to os
+   */
+  friend std::ostream& operator<< <T, Compare, Alloc> (std::ostream& os, const bplus_tree<T, Compare, Alloc>& tree);
+
+  /** Iterator type definitions **/
+
+  typedef bplus_iterator<T> iterator;
+  typedef const_bplus_iterator<T> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef btree_range<iterator> range_type;
+  typedef btree_range<const_iterator> const_range_type;
+
+  //non-const and const iterators for begin() and end(), both O(1) as the first and last leaves are kept
+  iterator begin() { return iterator(head, 0); }
+  iterator end() { return iterator(tail, tail->keys.size()); }
+
+  const_iterator begin() const { return const_iterator(head, 0); }
+  const_iterator end() const { return const_iterator(tail, tail->keys.size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  /**
+    * Returns an iterator to the matching element, or end()
+    * if the element could not be found.
+    *
+    * @param elem the client element we are trying to match.
+    * @return an iterator to the matching element, or end().
+    */
+  iterator find(const T& elem);
+  const_iterator find(const T& elem) const;
+
+  /**
+    * Returns an iterator to the first element not ordered before elem,
+    * or end() if every element is ordered before it.
+    *
+    * @param elem the client element to search for.
+    * @return an iterator to the first element not less than elem.
+    */
+  iterator lower_bound(const T& elem);
+  const_iterator lower_bound(const T& elem) const;
+
+  /**
+    * Returns an iterator to the first element ordered after elem,
+    * or end() if no element is ordered after it.
+    *
+    * @param elem the client element to search for.
+    * @return an iterator to the first element greater than elem.
+    */
+  iterator upper_bound(const T& elem);
+  const_iterator upper_bound(const T& elem) const;
+
+  /**
+    * Returns the range of elements equivalent to elem, which is
+    * either empty or holds exactly one element.
+    *
+    * @param elem the client element to search for.
+    * @return a pair holding lower_bound(elem) and upper_bound(elem).
+    */
+  std::pair<iterator, iterator> equal_range(const T& elem);
+  std::pair<const_iterator, const_iterator> equal_range(const T& elem) const;
+
+  /**
+    * Returns a view over every element in the half-open interval [lo, hi).
+    * Both ends are positioned in O(log n) and the scan then walks the leaves.
+    *
+    * @param lo the lowest element to include.
+    * @param hi the bound to stop before. If hi is ordered before lo the range is empty.
+    * @return a range from lower_bound(lo) to lower_bound(hi).
+    */
+  range_type range(const T& lo, const T& hi);
+  const_range_type range(const T& lo, const T& hi) const;
+
+  /**
+    * Inserts elem into the tree if no equal element is present.
+    * Iterators into the tree are invalidated by the insertion.
+    *
+    * @param elem the element to insert.
+    * @return a pair whose first field is an iterator positioned at
+    *         the element equal to elem and whose second field
+    *         indicates whether elem was inserted.
+    */
+  std::pair<iterator, bool> insert(const T& elem);
+
+  /**
+    * Removes the element at pos. Other iterators into the tree are invalidated.
+    *
+    * @param pos an iterator positioned at a valid element of this tree.
+    * @return an iterator positioned at the element that followed the
+    *         removed element, or end() if it was the last.
+    */
+  iterator erase(iterator pos);
+
+  /**
+    * Removes the element equal to elem, if there is one.
+    *
+    * @param elem the element to remove.
+    * @return the number of elements removed (0 or 1).
+    */
+  size_t erase(const T& elem);
+
+  /**
+    * Removes every element, leaving an empty tree.
+    */
+  void clear();
+
+  /**
+    * Returns the allocator node slabs are obtained from.
+    */
+  Alloc get_allocator() const { return static_cast<const btree_alloc_pool<Alloc>&>(*pool).get_allocator(); }
+
+  /**
+    * Returns the number of levels in the tree, which is 0 for an empty tree.
+    * All leaves are at the same depth.
+    */
+  size_t height() const;
+
+  /**
+    * Destructor
+    * Releases every node back to the pool, which returns its slabs to the allocator.
+    */
+  ~bplus_tree();
+
+ private:
+  typedef bplus_node<T> Node;
+
+  //Size of each node
+  size_t maxElements;
+
+  //Ordering of elements
+  Compare comp;
+
+  //Pool every node is allocated from. Declared before the nodes so it outlives them.
+  std::unique_ptr<btree_pool> pool;
+
+  //The root node, along with the first and last leaves where scans start
+  Node *root;
+  Node *head;
+  Node *tail;
+
+  //Copy the nodes below source into dest, linking up copied leaves in order
+  void copyTree(const Node *source, Node *dest, Node*& lastLeaf);
+
+  //Descend to the leaf which holds or would hold elem
+  const Node* findLeaf(const T& elem) const;
+
+  //Locate the leaf and slot of a lower or upper bound
+  std::pair<const Node*, size_t> findBound(const T& elem, bool upper) const;
+
+  //Insertion and erase helpers, tracked and trackedPos follow an element in a leaf as keys move
+  Node* splitNode(Node *node, Node*& tracked, size_t& trackedPos);
+  void rebalance(Node *node, Node*& tracked, size_t& trackedPos);
+  void borrowFromLeft(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+  void borrowFromRight(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+  void mergeChildren(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+
+  //Node memory management
+  void deleteChildren(Node *node);
+  Node* newNode(Node *parent);
+  void deleteNode(Node *node);
+};
+
+#include "bplus_tree.tem"
+
+#endif
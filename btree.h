@@ -15,36 +15,99 @@
 #include <iostream>
 #include <cstddef>
 #include <utility>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
 #include <queue>
 
-//Include our btree iterator
+//Include our btree nodes and iterator
+#include "btree_node.h"
 #include "btree_iterator.h"
+#include "btree_search.h"
+#include "btree_stream.h"
+#include "btree_parallel.h"
+#include "btree_stats.h"
 
 //Use standard namespace
 using namespace std;
 
 //Add declarations for non-template friends
-template <typename T> class btree;
-template <typename T> std::ostream& operator<<(std::ostream& os, const btree<T>& tree);
+template <typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>, size_t Fanout = 0,
+          typename Mapped = void, bool Multi = false> class btree;
+template <typename T, typename Compare, typename Alloc, size_t Fanout, typename Mapped, bool Multi> std::ostream& operator<<(std::ostream& os, const btree<T, Compare, Alloc, Fanout, Mapped, Multi>& tree);
 
-template <typename T> 
+/*
+ * T is the element type, ordered by Compare. All node memory comes from a pool
+ * which takes its slabs from an allocator of type Alloc.
+ *
+ * Fanout fixes the maximum number of elements per node at compile time, making
+ * node size checks and searches constant bounded. The default of 0 leaves it to
+ * the constructor.
+ *
+ * A Compare which declares is_transparent (such as std::less<>) also enables lookups
+ * by any type it can order against T, e.g. finding a const char* in a btree of strings
+ * without constructing a temporary std::string.
+ *
+ * Mapped and Multi configure the same tree for btree_map, btree_multiset and btree_multimap
+ * (see btree_map.h). A Mapped type other than void gives each element (then a key) a mapped
+ * value, stored in an array beside the keys, and Multi allows equivalent elements, which are
+ * kept in insertion order.
+*/
+template <typename T, typename Compare, typename Alloc, size_t Fanout, typename Mapped, bool Multi>
 class btree {
  public:
   /**
    * Constructs an empty btree.  Note that
    * the elements stored in your btree must
-   * have a well-defined zero-arg constructor,
-   * copy constructor, operator=, and destructor.
+   * have a well-defined move constructor,
+   * move assignment and destructor, as nodes
+   * shift and split by moving them. A copy
+   * constructor is only needed to insert copies
+   * or to copy the tree, and no zero-arg
+   * constructor is needed at all.
    * The elements must also know how to order themselves
-   * relative to each other by implementing operator<
-   * and operator==. (These are already implemented on
-   * behalf of all built-ins: ints, doubles, strings, etc.)
-   * 
+   * relative to each other, by default through operator<.
+   * (This is already implemented on behalf of all built-ins:
+   * ints, doubles, strings, etc.) Another strict weak ordering
+   * can be supplied as Compare, elements are then equal when
+   * neither orders before the other.
+   *
+   * A full node is split around its median as it overflows, so a
+   * node must be able to hold at least two elements. Smaller values
+   * of maxNodeElems are rounded up to two. When the tree's Fanout is
+   * fixed at compile time, maxNodeElems is ignored.
+   *
+   * Nodes are allocated from slabs obtained through alloc, which
+   * may be a std::pmr::polymorphic_allocator to draw every node
+   * from a client supplied memory resource.
+   *
    * @param maxNodeElems the maximum number of elements
    *        that can be stored in each B-Tree node
+   * @param comp the ordering used to compare elements
+   * @param alloc the allocator node slabs are obtained from
    */
-   btree(size_t maxNodeElems = 40) : maxElements(maxNodeElems) {};
+  btree(size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc());
+
+  /**
+   * Constructs a btree holding the elements of the range [first, last).
+   *
+   * Sorted input is loaded bottom-up in a single O(n) pass: each node is
+   * packed full before the next value is promoted into its parent, rather
+   * than descending from the root once per element. Duplicate values are
+   * skipped, unless the tree is Multi. Should an element arrive out of order, the elements loaded so
+   * far are kept and the remainder of the range is inserted one at a time.
+   *
+   * @param first an input iterator positioned at the first element to load
+   * @param last an input iterator positioned after the last element to load
+   * @param maxNodeElems the maximum number of elements
+   *        that can be stored in each B-Tree node
+   * @param comp the ordering used to compare elements
+   * @param alloc the allocator node slabs are obtained from
+   */
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  btree(InputIt first, InputIt last, size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc());
 
   /**
    * The copy constructor and  assignment operator.
@@ -61,7 +124,7 @@ class btree {
    *
    * @param original a const lvalue reference to a B-Tree object
    */
-  btree(const btree<T>& original);
+  btree(const btree<T, Compare, Alloc, Fanout, Mapped, Multi>& original);
 
   /** 
    * Move constructor
@@ -69,7 +132,7 @@ class btree {
    *
    * @param original an rvalue reference to a B-Tree object
    */
-  btree(btree<T>&& original);
+  btree(btree<T, Compare, Alloc, Fanout, Mapped, Multi>&& original);
   
   
   /** 
@@ -78,7 +141,7 @@ class btree {
    *
    * @param rhs a const lvalue reference to a B-Tree object
    */
-  btree<T>& operator=(const btree<T>& rhs);
+  btree<T, Compare, Alloc, Fanout, Mapped, Multi>& operator=(const btree<T, Compare, Alloc, Fanout, Mapped, Multi>& rhs);
 
   /** 
    * Move assignment
@@ -87,7 +150,7 @@ class btree {
    *
    * @param rhs a const reference to a B-Tree object
    */
-  btree<T>& operator=(btree<T>&& rhs);
+  btree<T, Compare, Alloc, Fanout, Mapped, Multi>& operator=(btree<T, Compare, Alloc, Fanout, Mapped, Multi>&& rhs);
 
   /**
    * Puts a breadth-first traversal of the B-Tree onto the output
@@ -98,18 +161,20 @@ class btree {
    * @param tree a const reference to a B-Tree object
    * @return a reference to os
    */
-  friend std::ostream& operator<< <T> (std::ostream& os, const btree<T>& tree);
+  friend std::ostream& operator<< <T, Compare, Alloc, Fanout, Mapped, Multi> (std::ostream& os, const btree<T, Compare, Alloc, Fanout, Mapped, Multi>& tree);
 
   /** Iterator type definitions **/
 
   //Give friendship to iterator classes
-  friend class btree_iterator<T>;
-  friend class const_btree_iterator<T>;
+  friend class btree_iterator<T, Mapped>;
+  friend class const_btree_iterator<T, Mapped>;
 
-  typedef btree_iterator<T> iterator;
-  typedef const_btree_iterator<T> const_iterator;
+  typedef btree_iterator<T, Mapped> iterator;
+  typedef const_btree_iterator<T, Mapped> const_iterator;
   typedef std::reverse_iterator<iterator> reverse_iterator;
   typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef btree_range<iterator> range_type;
+  typedef btree_range<const_iterator> const_range_type;
 
   //non-const and const iterators for begin() and end()
   iterator begin();
@@ -156,6 +221,168 @@ class btree {
     *         const end() returns if no such match was ever found.
     */
   const_iterator find(const T& elem) const;
+
+  /**
+    * Returns an iterator to the first element not ordered before elem,
+    * or end() if every element is ordered before it.
+    *
+    * Complexity: O(log n), a single descent from the root.
+    *
+    * @param elem the client element to search for.
+    * @return an iterator to the first element not less than elem.
+    */
+  iterator lower_bound(const T& elem);
+  const_iterator lower_bound(const T& elem) const;
+
+  /**
+    * Returns an iterator to the first element ordered after elem,
+    * or end() if no element is ordered after it.
+    *
+    * Complexity: O(log n), a single descent from the root.
+    *
+    * @param elem the client element to search for.
+    * @return an iterator to the first element greater than elem.
+    */
+  iterator upper_bound(const T& elem);
+  const_iterator upper_bound(const T& elem) const;
+
+  /**
+    * Returns the range of elements equivalent to elem, which is
+    * either empty or holds one element, or every equivalent element
+    * of a Multi tree.
+    *
+    * @param elem the client element to search for.
+    * @return a pair holding lower_bound(elem) and upper_bound(elem).
+    */
+  std::pair<iterator, iterator> equal_range(const T& elem);
+  std::pair<const_iterator, const_iterator> equal_range(const T& elem) const;
+
+  /**
+    * Returns the number of elements equivalent to elem, which is 0 or 1,
+    * or any number of equivalent elements for a Multi tree.
+    *
+    * @param elem the client element to search for.
+    * @return the number of matching elements present.
+    */
+  size_t count(const T& elem) const;
+
+  /**
+    * Returns whether an element equivalent to elem is present.
+    *
+    * @param elem the client element to search for.
+    * @return true if a matching element is present.
+    */
+  bool contains(const T& elem) const;
+
+  /**
+    * Heterogeneous lookups, only available when Compare declares is_transparent.
+    * Identical to the versions above, but key may be of any type that Compare
+    * can order against T in both directions, so no temporary T is constructed.
+    *
+    * @param key the value to search for, e.g. a const char* or std::string_view
+    *        when T is std::string and Compare is std::less<>.
+    */
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const K& key);
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const K& key) const;
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const K& key);
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const K& key) const;
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  iterator upper_bound(const K& key);
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator upper_bound(const K& key) const;
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K& key);
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K& key) const;
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  size_t count(const K& key) const;
+
+  template <typename K, typename C = Compare, typename = typename C::is_transparent>
+  bool contains(const K& key) const;
+
+  /**
+    * Finds every key of [first, last), writing what find would return for
+    * each to out, in the order of the keys. The descents of a group of keys
+    * are interleaved, each prefetching the next node it needs while the
+    * others are searched, so the cache misses of different keys overlap
+    * instead of being waited on one after another as in a loop of find.
+    * Trees larger than the cache gain the most.
+    *
+    * @param first, last the keys to search for, of type T or, with a
+    *        transparent Compare, of any type Compare orders against T.
+    * @param out receives an iterator per key, end() for missing keys.
+    * @return out advanced past the last iterator written.
+    */
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out);
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const;
+
+  /**
+    * Identical to find_many, but writes whether each key is present.
+    *
+    * @param out receives a bool per key.
+    * @return out advanced past the last value written.
+    */
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt contains_many(ForwardIt first, ForwardIt last, OutputIt out) const;
+
+  /**
+    * Returns a view over every element in the half-open interval [lo, hi),
+    * usable directly in a range based for loop. Both ends are positioned in
+    * O(log n), so scanning k elements costs O(log n + k).
+    *
+    * @param lo the lowest element to include.
+    * @param hi the bound to stop before. If hi is ordered before lo the range is empty.
+    * @return a range from lower_bound(lo) to lower_bound(hi).
+    */
+  range_type range(const T& lo, const T& hi);
+  const_range_type range(const T& lo, const T& hi) const;
+
+  /**
+    * Splits the btree into consecutive, disjoint ranges which together
+    * hold every element, for threads to walk concurrently (see
+    * parallel_for_each). Ranges are cut at the separators of internal
+    * nodes, descending only as far as needed for the requested number,
+    * so each holds about the same number of elements.
+    *
+    * @param pieces the number of ranges wanted. Fewer are returned when
+    *        the tree is too small, and none when it is empty.
+    * @return the ranges, in order.
+    */
+  std::vector<const_range_type> split(size_t pieces) const;
+
+  /**
+    * Returns the number of elements ordered before elem, which is the
+    * position lower_bound(elem) would return. Each node keeps the size
+    * of its subtree, so ranks are summed on the way down from the root.
+    *
+    * Complexity: O(log n)
+    *
+    * @param elem the element to rank.
+    * @return the index elem has, or would have once inserted, in order.
+    */
+  size_t rank(const T& elem) const;
+
+  /**
+    * Returns an iterator to the element at index n in order, found by
+    * descending through the subtree sizes, or end() if n is not less
+    * than size(). nth(i) - begin() is i, and begin() + i is nth(i).
+    *
+    * Complexity: O(log n)
+    *
+    * @param n the index of the element, from 0.
+    */
+  iterator nth(size_t n);
+  const_iterator nth(size_t n) const;
       
   /**
     * Operation which inserts the specified element
@@ -173,10 +400,14 @@ class btree {
     * second value can be checked to after an insertion to decide whether
     * or not the btree got bigger.
     *
-    * The insert method makes use of T's zero-arg constructor and 
-    * operator= method, and if these things aren't available, 
-    * then the call to btree<T>::insert will not compile.  The implementation
-    * also makes use of the class's operator== and operator< as well.
+    * As values are kept in contiguous arrays within each node, an insertion
+    * may shift existing values and so invalidates previously obtained iterators.
+    *
+    * The insert method copies elem into the btree, and values are moved
+    * about by T's move constructor and move assignment as nodes shift
+    * and split. If these things aren't available, then the call to
+    * btree<T>::insert will not compile. T needs no zero-arg constructor.
+    * The implementation also orders elements with Compare as well.
     *
     * @param elem the element to be inserted.
     * @return a pair whose first field is an iterator positioned at
@@ -186,49 +417,232 @@ class btree {
     */
   std::pair<iterator, bool> insert(const T& elem);
 
+  /**
+    * Identical in functionality to the insert above, save the fact that
+    * elem is moved into the btree rather than copied. elem is left
+    * untouched when a matching element is already present.
+    *
+    * @param elem the element to be inserted.
+    * @return as for the copying insert.
+    */
+  std::pair<iterator, bool> insert(T&& elem);
+
+  /**
+    * Constructs an element from args and inserts it if no matching element
+    * is present. The element is constructed once, then moved into its slot
+    * in a node, so T need only be move constructible.
+    *
+    * @param args the arguments forwarded to T's constructor.
+    * @return as for insert.
+    */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+
+  /**
+    * Inserts elem using hint as a guess of where it belongs, namely directly
+    * before the element hint is positioned at. When elem is ordered between
+    * that element and the one before it, elem goes straight into the leaf slot
+    * between the two without any searching from the root, so appending
+    * increasing elements at end() costs amortized O(1) apart from following
+    * the rightmost child links down to the last leaf. A wrong hint costs a
+    * couple of comparisons on top of an ordinary insert.
+    *
+    * @param hint an iterator into this btree, positioned at the element
+    *        elem is expected to go before, or end().
+    * @param elem the element to be inserted.
+    * @return an iterator positioned at the inserted element, or at the
+    *         matching element if one was already present.
+    */
+  iterator insert(const_iterator hint, const T& elem);
+  iterator insert(const_iterator hint, T&& elem);
+
+  /**
+    * Constructs an element from args and inserts it using hint as insert does.
+    *
+    * @param hint an iterator positioned where the new element is expected to go before.
+    * @param args the arguments forwarded to T's constructor.
+    * @return an iterator positioned at the inserted or the matching element.
+    */
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args);
+
+  /**
+    * Inserts every element of the range [first, last) not already present,
+    * in one pass over the tree from left to right. The batch is copied and
+    * sorted, unless it already is, and each leaf it reaches takes all of its
+    * elements belonging there at once: the leaf is merged with them and, if
+    * they do not fit, split into as many evenly filled leaves as needed.
+    * The next leaf is found by climbing only as far up from the last as the
+    * next element requires, rather than descending from the root each time.
+    *
+    * Of equivalent elements within the batch only the first is inserted, as
+    * inserting the range one element at a time would, unless the tree is Multi.
+    * Maps take key and mapped value pairs, and leave present keys unchanged.
+    *
+    * @param first an input iterator positioned at the first element to insert
+    * @param last an input iterator positioned after the last element to insert
+    * @return the number of elements inserted.
+    */
+  template <typename InputIt>
+  size_t insert_batch(InputIt first, InputIt last);
+
+  /**
+    * Operation which removes the element at the specified position
+    * from the btree. A node left with fewer than half of maxNodeElems
+    * elements borrows from a neighbouring sibling, or is merged with it
+    * when neither sibling has elements to spare. The root shrinks once it
+    * runs out of elements, so every leaf stays at the same depth.
+    *
+    * Like an insertion, removal shifts values within nodes and so
+    * invalidates all previously obtained iterators other than the
+    * one returned.
+    *
+    * @param pos an iterator positioned at a valid element of this btree.
+    * @return an iterator positioned at the element that followed the
+    *         removed element, or end() if it was the last element.
+    */
+  iterator erase(iterator pos);
+
+  /**
+    * Removes all elements in the range [first, last) from the btree.
+    *
+    * @param first an iterator positioned at the first element to remove.
+    * @param last an iterator positioned after the last element to remove.
+    * @return an iterator positioned at the element that followed the
+    *         removed range, or end() if the range reached the end.
+    */
+  iterator erase(iterator first, iterator last);
+
+  /**
+    * Removes the matching element from the btree, if present.
+    *
+    * @param elem the client element to be removed.
+    * @return the number of elements removed, either zero or one,
+    *         or every equivalent element of a Multi tree.
+    */
+  size_t erase(const T& elem);
+
+  /**
+    * Replaces the contents of the btree with the sorted range [first, last),
+    * building nodes bottom-up in O(n) as the bulk-loading constructor does.
+    *
+    * Nodes are filled to the given fraction of maxNodeElems, which leaves
+    * room for later insertions before any node needs splitting. Nodes are
+    * never filled below half of maxNodeElems. Input which turns out not to
+    * be sorted is still loaded correctly, at the cost of inserting the
+    * remainder of the range one element at a time.
+    *
+    * @param first an input iterator positioned at the first element to load
+    * @param last an input iterator positioned after the last element to load
+    * @param fillFactor the fraction of each node to fill, between 0.5 and 1
+    */
+  template <typename InputIt>
+  void assign_sorted(InputIt first, InputIt last, double fillFactor = 1.0);
+
+  /**
+    * Replaces the contents of the btree with the range [first, last), in
+    * any order, using several threads. The range is copied and sorted on
+    * every thread, duplicates are dropped unless the tree is Multi (the
+    * first of each is kept, as insert would), and the shape of the whole
+    * tree is laid out before its leaves are filled, each thread taking
+    * its own run of leaves.
+    *
+    * Should an exception be thrown, the btree is left unchanged.
+    *
+    * @param first an input iterator positioned at the first element to load
+    * @param last an input iterator positioned after the last element to load
+    * @param threads the number of threads to use, 0 for one per hardware thread
+    * @param fillFactor the fraction of each node to fill, as for assign_sorted
+    */
+  template <typename InputIt>
+  void assign_parallel(InputIt first, InputIt last, size_t threads = 0, double fillFactor = 1.0);
+
+  /**
+    * Writes the elements of the btree to os in order, as a binary stream
+    * (see btree_stream.h) which load() can rebuild the tree from. Elements
+    * are encoded and written a block at a time in one pass over the tree.
+    *
+    * Elements, and the mapped values of a map, must be trivially copyable
+    * or strings, unless btree_codec is specialised for them.
+    *
+    * @param os a binary output stream
+    * @throws std::runtime_error if os fails
+    */
+  void save(std::ostream& os) const;
+
+  /**
+    * Replaces the contents of the btree with a stream written by save(),
+    * bulk loading the elements as they are read rather than inserting
+    * them, with only a block of the stream held in memory at a time.
+    * A tree whose node size is not fixed takes the saved tree's node size.
+    *
+    * The stream's checksum and element count are checked once it has
+    * been read. Should the stream be corrupt, truncated, or saved from a
+    * btree of other element types, the btree is left unchanged.
+    *
+    * @param is a binary input stream positioned at the start of a saved tree
+    * @param fillFactor the fraction of each node to fill, as for assign_sorted
+    * @throws std::runtime_error if the stream cannot be read or fails its checks
+    */
+  void load(std::istream& is, double fillFactor = 1.0);
+
+  /**
+    * Removes all elements from the btree.
+    */
+  void clear();
+
+  /**
+    * Returns a copy of the allocator node slabs are obtained from.
+    */
+  Alloc get_allocator() const { return static_cast<const btree_alloc_pool<Alloc>&>(*pool).get_allocator(); }
+
+  /**
+    * Returns the number of elements in the btree, kept by the root node.
+    */
+  size_t size() const { return root.subtreeSize; }
+  bool empty() const { return root.subtreeSize == 0; }
+
+  /**
+    * Returns the number of levels in the btree. Every leaf sits at
+    * this depth, as insertions split full nodes rather than extending
+    * a single branch. An empty btree has a height of zero.
+    *
+    * @return the number of node levels from the root to the leaves.
+    */
+  size_t height() const;
+
+  /**
+    * Measures the shape of the btree in a single pass over its nodes:
+    * its height, node and leaf counts, how full nodes are on average,
+    * and the memory taken by its nodes and held by its pool.
+    *
+    * Complexity: O(n / maxNodeElems), every node is visited once
+    *
+    * @return the measurements, see btree_stats.h
+    */
+  btree_stats stats() const;
+
   /**
     * Disposes of all internal resources, which includes
     * the disposal of any client objects previously
     * inserted using the insert operation. 
-    * Check that your implementation does not leak memory!
+    * Node memory is returned to the allocator a slab at a time,
+    * and elements which need no destructor are not visited at all.
     */
   ~btree();
 
   
-private:
-
-  struct Element;
-
-  /*
-  * A node consists of a mapping of values to Elements.
-  * A map is ideal due to its weak ordering on inserted values of type T.
-  * Each node is aware of its parent node to simplify later traversal algorithms.
-  */
-  struct Node {
-    //Node constructor
-    Node(Node* p = nullptr) : parent(p), elements(std::map<T, Element>()) {}
-
-    //Structures
-    Node* parent;
-    std::map<T, Element> elements;
-  };
-
-  /*
-  * Each node has up to 'maxNodeElems' elements. Each element has a value T.
-  * Each element also has a left and right child node which have value 'nullptr' to indicate no child.
-  */
-  struct Element {
-    //Element constructor
-    Element(T value = T(), Node *left = nullptr, Node *right = nullptr) : value(value), leftChild(left), rightChild(right) {}
-    
-    //Structures
-    T value;
-    Node *leftChild;
-    Node *rightChild;
+protected:
+
+  //Nodes are shared with the iterators, see btree_node.h
+  typedef btree_node<T, Mapped> Node;
 
-  };
+  //The max number of elements each node may contain, a constant when Fanout is fixed
+  size_t maxElements() const { return fanout.maxElements(); }
 
-  size_t maxElements;  //stores the max number of elements each node may contain
+  btree_fanout<Fanout> fanout;  //stores the max number of elements each node may contain
+  Compare comp;  //ordering of elements
+  std::unique_ptr<btree_pool> pool;  //owns the memory of every node, declared before root so it outlives it
   Node root;  //store the root node as all other nodes will be linked to it
 
 
@@ -240,15 +654,91 @@ private:
   //Recursive print node function to print an entire tree in breadth first order
   static void printBTree(std::ostream& os, const Node *node, std::queue<Node*>& childs, const T &lastValue); //declare static so nonmember << operator may use it
 
-  //Recursive insertion function to find and insert an elem (if it is unique)
-  std::pair<typename btree<T>::iterator, bool> recursiveInsert(Node *node, const T& elem);
+  //Recursive insertion function to find and insert an elem (if it is unique), copying or moving it as K allows.
+  //The mapped value of a map element is constructed from args.
+  template <typename K, typename... Args>
+  std::pair<typename btree<T, Compare, Alloc, Fanout, Mapped, Multi>::iterator, bool> recursiveInsert(Node *node, K&& elem, Args&&... args);
+
+  //Insert an elem next to hint if it belongs there, otherwise from the root
+  template <typename K, typename... Args>
+  iterator hintedInsert(const_iterator hint, K&& elem, Args&&... args);
+
+  //Add an elem to a leaf at the given slot, splitting overfull nodes on the way back up
+  template <typename K, typename... Args>
+  iterator insertAt(Node *leaf, size_t pos, K&& elem, Args&&... args);
+
+  //Insert an input value, which is an element for sets and a key and mapped value pair for maps
+  template <typename P>
+  std::pair<iterator, bool> insertValue(P&& value);
+
+  //The element or key of an input value
+  static const T& keyOf(const T& value) { return value; }
+  template <typename P>
+  static const T& keyOf(const P& value) { return value.first; }
+
+  //Split an overfull node around its median, tracking the location of an element as it moves
+  Node* splitNode(Node *node, Node*& tracked, size_t& trackedPos);
+
+  //Bulk load a range into an empty btree, falling back to insert once the range is out of order
+  template <typename InputIt>
+  void bulkLoad(InputIt first, InputIt last, double fillFactor);
+
+  //Append a value to the open node of a level during a bulk load, promoting it when that node is full
+  template <typename P>
+  size_t bulkAppend(std::vector<Node*>& spine, size_t level, const P& value, size_t fill);
+
+  //Build an empty btree from sorted values with no duplicates, laying out every node before filling the leaves on threads
+  template <typename V>
+  void parallelLoad(std::vector<V>& values, size_t threads, double fillFactor);
+
+  //Insert sorted values, with no duplicates unless Multi, in one left to right pass returning how many were inserted
+  template <typename V>
+  size_t mergeSorted(std::vector<V>& values);
+
+  //Merge values [first, last), which all belong in leaf and the first of them at slot pos, into it,
+  //splitting it as needed and moving leaf to the last leaf filled
+  template <typename V>
+  size_t mergeLeaf(Node*& leaf, size_t pos, std::vector<V>& values, size_t first, size_t last, Node& scratch);
+
+  //Recompute the subtree size of every node below and including node, after nodes were built without keeping them
+  static void recountSubtree(Node *node);
+
+  //Grow the tree by a level, moving the root contents down into a new only child of the root
+  Node* growRoot();
+
+  //Restore the minimum fill of a node after a removal by borrowing from or merging with its siblings
+  void rebalance(Node *node, Node*& tracked, size_t& trackedPos);
+
+  //Move a value through the parent from the left sibling of child slot into that child
+  void borrowFromLeft(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+
+  //Move a value through the parent from the right sibling of child slot into that child
+  void borrowFromRight(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+
+  //Merge child slot + 1 and the separating parent value into child slot
+  void mergeChildren(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
 
   //Recursive find functions, non-const and const versions provided to cater for non-const and const BTree's
-  iterator recursiveFind(Node* node, const T& elem);
-  const_iterator recursiveFind(const Node* node, const T& elem) const;
+  //K is T itself, or any key type a transparent Compare orders against T
+  template <typename K>
+  iterator recursiveFind(Node* node, const K& elem);
+  template <typename K>
+  const_iterator recursiveFind(const Node* node, const K& elem) const;
+
+  //Locate the node and slot of a lower or upper bound in a single descent
+  template <typename K>
+  std::pair<const Node*, size_t> findBound(const K& elem, bool upper) const;
+
+  //Find the keys of [first, last) with their descents interleaved, calling found(node, slot) for each in order
+  template <typename ForwardIt, typename F>
+  void findMany(ForwardIt first, ForwardIt last, F found) const;
 
-  //Recursively element delete function that deletes an element and all of its linked childs
-  void deleteElement(Element& e);
+  //Recursive node delete function that deletes all of a node's linked childs
+  void deleteChildren(Node *node);
+
+  //Allocate and construct a node from the pool, and destroy and release it
+  Node* newNode(Node *parent);
+  void deleteNode(Node *node);
 
 };
 
@@ -264,6 +754,13 @@ private:
  * and the compiler would be peeved.
  */
 
+/*
+ * A btree whose node capacity is fixed at compile time, by default to fill
+ * eight cache lines with keys (see btree_default_fanout).
+*/
+template <typename T, size_t Fanout = btree_default_fanout<T>::value>
+using fixed_btree = btree<T, std::less<T>, std::allocator<T>, Fanout>;
+
 #include "btree.tem"
 
 #endif
@@ -0,0 +1,55 @@
+#ifndef BTREE_EPOCH_H
+#define BTREE_EPOCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Epoch based reclamation, deciding when memory a writer has unlinked can no longer be reached by any reader.
+ *
+ * A writer advances the epoch each time it publishes a new version of a structure, and tags whatever the new
+ * version no longer links to with the new epoch. A reader pins the epoch it starts at in a slot of its own, and
+ * can then reach nothing tagged with a later epoch than that. Anything tagged with an epoch no later than the
+ * oldest one pinned is therefore unreachable, and can be freed.
+ *
+ * Readers claim slots from a list which only grows, so pinning never blocks and never waits on a writer. A slot
+ * is released for reuse when its reader unpins.
+*/
+class btree_epoch {
+public:
+  //The epoch a slot holds when no reader has it pinned
+  static constexpr uint64_t kUnpinned = UINT64_MAX;
+
+  //A reader's slot, on a cache line of its own so readers do not contend
+  struct alignas(64) slot {
+    std::atomic<uint64_t> pinned{kUnpinned};
+    std::atomic<bool> owned{false};
+    slot *next = nullptr;
+  };
+
+  btree_epoch() : epoch(0), slots(nullptr) {}
+  ~btree_epoch();
+
+  btree_epoch(const btree_epoch&) = delete;
+  btree_epoch& operator=(const btree_epoch&) = delete;
+
+  //Claim a slot and pin the current epoch in it, everything published at or after that epoch staying reachable
+  slot* pin();
+  void unpin(slot *s);
+
+  //Move to the next epoch once a new version is published, returning the epoch to tag unlinked memory with
+  uint64_t advance() { return epoch.fetch_add(1, std::memory_order_seq_cst) + 1; }
+
+  //The oldest epoch any reader has pinned, or kUnpinned when there are no readers
+  uint64_t oldestPinned() const;
+
+private:
+  std::atomic<uint64_t> epoch;
+  std::atomic<slot*> slots;
+};
+
+#include "btree_epoch.tem"
+
+#endif
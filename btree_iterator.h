@@ -2,115 +2,183 @@
 #define BTREE_ITERATOR_H
 
 #include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "btree_stats.h"
 
 /**
  * btree_iterator and const_btree_iterator implementations.
  *
  * Will allow in-order (from lowest to highest) traversal through a btree. 
- * Internally, the iterator uses a map<T, Element> iterator in addition with a currend 'node' and didTraverse bool to indicate an upwards traversal.
+ * Internally, the iterator stores the current 'node' and the slot 'pos' of the element within that node's key array.
+ * The end() position is the slot one past the last key of the root node.
+ *
+ * Nodes keep the number of elements below them, so an iterator can also be moved any number of elements, or
+ * measured against another, in O(log n). Iterators stay bidirectional, as these steps are not O(1).
  *
+ * Iterators over a map (Mapped is not void) refer to a key and its mapped value, which are stored
+ * in separate arrays, so they dereference to a pair of references rather than a reference to a pair.
+ *
+*/
+
+template <typename T, typename Compare, typename Alloc, size_t Fanout, typename Mapped, bool Multi> class btree;
+template <typename T, typename Mapped> struct btree_node;
+template <typename T, typename Mapped = void> class btree_iterator;
+template <typename T, typename Mapped = void> class const_btree_iterator;
+
+/*
+* The result of operator-> on a map iterator. It holds the pair of references operator* returns,
+* so it->first and it->second reach the key and mapped value in the node.
 */
+template <typename Reference>
+struct btree_arrow_proxy {
+  const Reference* operator->() const { return &ref; }
 
-template <typename T> class btree;
-template <typename T> class const_btree_iterator;
+  Reference ref;
+};
 
-template <typename T>
+/*
+* Element types seen through an iterator, Const for a const_btree_iterator.
+* A set iterator refers directly to its element, a map iterator to a key and mapped value pair.
+*/
+template <typename T, typename Mapped, bool Const>
+struct btree_iterator_types {
+  typedef std::pair<const T, Mapped> value_type;
+  typedef std::pair<const T&, typename std::conditional<Const, const Mapped&, Mapped&>::type> reference;
+  typedef btree_arrow_proxy<reference> pointer;
+};
+
+template <typename T, bool Const>
+struct btree_iterator_types<T, void, Const> {
+  typedef T value_type;
+  typedef typename std::conditional<Const, const T&, T&>::type reference;
+  typedef typename std::conditional<Const, const T*, T*>::type pointer;
+};
+
+template <typename T, typename Mapped>
 class btree_iterator {
 public:
-  friend class const_btree_iterator<T>;
+  friend class const_btree_iterator<T, Mapped>;
+  template <typename, typename, typename, size_t, typename, bool> friend class btree;
 
   typedef ptrdiff_t difference_type;
   typedef std::bidirectional_iterator_tag	iterator_category;
-  typedef T value_type;
-  typedef T* pointer;
-  typedef T& reference;
+  typedef typename btree_iterator_types<T, Mapped, false>::value_type value_type;
+  typedef typename btree_iterator_types<T, Mapped, false>::pointer pointer;
+  typedef typename btree_iterator_types<T, Mapped, false>::reference reference;
 
-  bool operator==(const btree_iterator<T>&) const;
-  bool operator!=(const btree_iterator<T>& other) const { return !operator==(other); }
+  bool operator==(const btree_iterator<T, Mapped>&) const;
+  bool operator!=(const btree_iterator<T, Mapped>& other) const { return !operator==(other); }
 
   reference operator*() const;
-  pointer operator->() const { return &(operator*()); }
-  btree_iterator<T>& operator=(const btree_iterator<T>&);
-  btree_iterator<T>& operator++(); //preinc
-  btree_iterator<T>& operator++(int); //postinc
-  btree_iterator<T>& operator--(); //predec
-  btree_iterator<T>& operator--(int); //postdec
-
-  //Constructors
-  btree_iterator() {};
-  btree_iterator(typename btree<T>::Node *n,
-    typename std::map<T, typename btree<T>::Element>::iterator it)
-    : node(n), it(it) {}
+  pointer operator->() const;
+  btree_iterator<T, Mapped>& operator++(); //preinc
+  btree_iterator<T, Mapped> operator++(int); //postinc
+  btree_iterator<T, Mapped>& operator--(); //predec
+  btree_iterator<T, Mapped> operator--(int); //postdec
+
+  //Move n elements on (or back), and count the elements between two iterators, in O(log n) from the subtree sizes
+  btree_iterator<T, Mapped>& operator+=(difference_type n);
+  btree_iterator<T, Mapped>& operator-=(difference_type n) { return *this += -n; }
+  btree_iterator<T, Mapped> operator+(difference_type n) const { btree_iterator<T, Mapped> copy(*this); return copy += n; }
+  btree_iterator<T, Mapped> operator-(difference_type n) const { btree_iterator<T, Mapped> copy(*this); return copy -= n; }
+  difference_type operator-(const btree_iterator<T, Mapped>& other) const;
+
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  btree_iterator() : node(nullptr), pos(0) {}
+  btree_iterator(btree_node<T, Mapped> *n, size_t pos)
+    : node(n), pos(pos) {}
 
 private:
-  //Store a current node as well as a map iterator
+  //Store a current node as well as a slot within its key array
   //This will be the underlying implementation of our iterator
-  typename btree<T>::Node *node;
-  typename std::map<T, typename btree<T>::Element>::iterator it;
-  bool didTraverse = false; //boolean true if last iteration traversed upwards (in the btree)
-
-  //Helper functions used for traversing the btree recursively
-  void forward_traverse_down(typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::iterator&);
-  void forward_traverse_up(typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::iterator&);
-  
-  void reverse_traverse_down(typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::iterator&);
-  void reverse_traverse_up(typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::iterator&);
+  btree_node<T, Mapped> *node;
+  size_t pos;
+
+  //Helper functions used for traversing between levels of the btree
+  void forward_traverse_down(btree_node<T, Mapped>*);
+  void forward_traverse_up();
+
+  void reverse_traverse_down(btree_node<T, Mapped>*);
+  void reverse_traverse_up();
 };
 
-template <typename T>
+template <typename T, typename Mapped>
 class const_btree_iterator {
 public:
   typedef ptrdiff_t difference_type;
   typedef std::bidirectional_iterator_tag iterator_category;
-  typedef T value_type;
-  typedef const T* pointer;
-  typedef const T& reference;
+  typedef typename btree_iterator_types<T, Mapped, true>::value_type value_type;
+  typedef typename btree_iterator_types<T, Mapped, true>::pointer pointer;
+  typedef typename btree_iterator_types<T, Mapped, true>::reference reference;
 
   bool operator==(const const_btree_iterator&) const;
   bool operator!=(const const_btree_iterator& other) const { return !operator==(other); }
 
-  bool operator==(const btree_iterator<T>&) const;
-  bool operator!=(const btree_iterator<T>& other) const { return !operator==(other);}
+  bool operator==(const btree_iterator<T, Mapped>&) const;
+  bool operator!=(const btree_iterator<T, Mapped>& other) const { return !operator==(other);}
 
   reference operator*() const;
-  pointer operator->() const { return &(operator*()); }
-  const_btree_iterator& operator=(const const_btree_iterator<T>&);
+  pointer operator->() const;
   const_btree_iterator& operator++(); //preinc
-  const_btree_iterator& operator++(int);  //postinc
+  const_btree_iterator operator++(int);  //postinc
   const_btree_iterator& operator--(); //predec
-  const_btree_iterator& operator--(int);  //post dec
+  const_btree_iterator operator--(int);  //post dec
+
+  //Move n elements on (or back), and count the elements between two iterators, in O(log n) from the subtree sizes
+  const_btree_iterator& operator+=(difference_type n);
+  const_btree_iterator& operator-=(difference_type n) { return *this += -n; }
+  const_btree_iterator operator+(difference_type n) const { const_btree_iterator copy(*this); return copy += n; }
+  const_btree_iterator operator-(difference_type n) const { const_btree_iterator copy(*this); return copy -= n; }
+  difference_type operator-(const const_btree_iterator& other) const;
   
-  //Constructors
-  const_btree_iterator() {};
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  const_btree_iterator() : node(nullptr), pos(0) {}
 
   //Allow conversion of btree_iterator to const_btree_iterator
-  const_btree_iterator(const btree_iterator<T>& it) : const_btree_iterator(it.node, it.it) {};
+  const_btree_iterator(const btree_iterator<T, Mapped>& it) : const_btree_iterator(it.node, it.pos) {};
 
-  const_btree_iterator(const typename btree<T>::Node *n,
-    typename std::map<T, typename btree<T>::Element>::const_iterator it)
-    : node(n), it(it) {}
+  const_btree_iterator(const btree_node<T, Mapped> *n, size_t pos)
+    : node(n), pos(pos) {}
 
 private:
-  //Store a current node as well as a map iterator
+  template <typename, typename, typename, size_t, typename, bool> friend class btree;
+
+  //Store a current node as well as a slot within its key array
   //This will be the underlying implementation of our iterator
-  const typename btree<T>::Node *node;
-  typename std::map<T, typename btree<T>::Element>::const_iterator it;
-  bool didTraverse = false; //boolean true if last iteration traversed upwards (in the btree)
-
-  //Helper functions used for traversing the btree recursively
-  void forward_traverse_down(const typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::const_iterator&);
-  void forward_traverse_up(const typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::const_iterator&);
-
-  void reverse_traverse_down(const typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::const_iterator&);
-  void reverse_traverse_up(const typename btree<T>::Node*,
-    typename std::map<T, typename btree<T>::Element>::const_iterator&);
+  const btree_node<T, Mapped> *node;
+  size_t pos;
+
+  //Helper functions used for traversing between levels of the btree
+  void forward_traverse_down(const btree_node<T, Mapped>*);
+  void forward_traverse_up();
+
+  void reverse_traverse_down(const btree_node<T, Mapped>*);
+  void reverse_traverse_up();
+};
+
+//Iterators are a node pointer and a slot, cheap enough to pass around in registers
+static_assert(std::is_trivially_copyable<btree_iterator<int> >::value, "btree_iterator must be trivially copyable");
+static_assert(std::is_trivially_copyable<const_btree_iterator<int> >::value, "const_btree_iterator must be trivially copyable");
+
+/*
+* A half-open [first, last) pair of iterators returned by btree::range,
+* so the elements between two bounds can be walked with a range based for loop.
+*/
+template <typename Iterator>
+class btree_range {
+public:
+  btree_range(Iterator first, Iterator last) : first(first), last(last) {}
+
+  Iterator begin() const { return first; }
+  Iterator end() const { return last; }
+  bool empty() const { return first == last; }
+
+private:
+  Iterator first;
+  Iterator last;
 };
 
 #include "btree_iterator.tem"
@@ -0,0 +1,198 @@
+/**
+ * btree_map, btree_multimap and btree_multiset are built on the
+ * same nodes and balancing as btree, which they derive from.
+ *
+ * A map stores its keys and mapped values in two parallel arrays
+ * within each node, so searches only ever touch densely packed keys
+ * however large the mapped values are. Iterators dereference to a
+ * pair of references to the key and its mapped value rather than to
+ * a stored std::pair, so iterate with auto, const auto& or a
+ * structured binding, e.g. for (auto [key, value] : map).
+ *
+ * The multi variants keep equivalent elements side by side in the
+ * order they were inserted, as std::multimap and std::multiset do.
+ */
+
+#ifndef BTREE_MAP_H
+#define BTREE_MAP_H
+
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "btree.h"
+
+/*
+* K is the key type, ordered by Compare, and V the type of the value mapped to each key.
+* As with btree, Alloc supplies the slabs node memory is carved from.
+*/
+template <typename K, typename V, typename Compare = std::less<K>, typename Alloc = std::allocator<std::pair<const K, V> >, size_t Fanout = 0>
+class btree_map : public btree<K, Compare, Alloc, Fanout, V, false> {
+  typedef btree<K, Compare, Alloc, Fanout, V, false> base;
+
+ public:
+  typedef K key_type;
+  typedef V mapped_type;
+  typedef std::pair<const K, V> value_type;
+  typedef typename base::iterator iterator;
+  typedef typename base::const_iterator const_iterator;
+
+  /**
+   * Constructs an empty btree_map, see btree for the parameters.
+   */
+  btree_map(size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+    : base(maxNodeElems, comp, alloc) {}
+
+  /**
+   * Constructs a btree_map holding the key and value pairs of the range [first, last),
+   * bulk loading sorted input in O(n) as btree does. Later pairs with a duplicate key are skipped.
+   */
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  btree_map(InputIt first, InputIt last, size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+    : base(first, last, maxNodeElems, comp, alloc) {}
+
+  /**
+    * Inserts a key and value pair if no element with an equivalent key is present.
+    *
+    * @param value the pair to insert, which is moved from when given as an rvalue.
+    * @return a pair holding an iterator to the element with the key, and whether it was inserted.
+    */
+  std::pair<iterator, bool> insert(const value_type& value);
+  std::pair<iterator, bool> insert(value_type&& value);
+
+  /**
+    * Inserts a key and value pair using hint as btree's hinted insert does.
+    *
+    * @return an iterator positioned at the element with the key.
+    */
+  iterator insert(const_iterator hint, const value_type& value);
+  iterator insert(const_iterator hint, value_type&& value);
+
+  /**
+    * Constructs a key and value pair from args and inserts it as insert does.
+    */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args);
+
+  /**
+    * Inserts key with a mapped value constructed from args if the key is not present.
+    * Nothing is constructed, and args are left untouched, when the key is already present.
+    *
+    * @param key the key to look up, copied or moved into the map only when inserted.
+    * @param args the arguments forwarded to the mapped value's constructor.
+    * @return a pair holding an iterator to the element with the key, and whether it was inserted.
+    */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K& key, Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args);
+
+  /**
+    * Assigns obj to the value mapped to key, inserting key first if it is not present.
+    *
+    * @return a pair holding an iterator to the element with the key, and whether it was inserted.
+    */
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const K& key, M&& obj);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj);
+
+  /**
+    * Returns the value mapped to key, inserting key with a value initialised mapped value if it is not present.
+    */
+  V& operator[](const K& key);
+  V& operator[](K&& key);
+
+  /**
+    * Returns the value mapped to key.
+    *
+    * @throws std::out_of_range if the key is not present.
+    */
+  V& at(const K& key);
+  const V& at(const K& key) const;
+};
+
+/*
+* A btree_map which may hold several elements with equivalent keys.
+*/
+template <typename K, typename V, typename Compare = std::less<K>, typename Alloc = std::allocator<std::pair<const K, V> >, size_t Fanout = 0>
+class btree_multimap : public btree<K, Compare, Alloc, Fanout, V, true> {
+  typedef btree<K, Compare, Alloc, Fanout, V, true> base;
+
+ public:
+  typedef K key_type;
+  typedef V mapped_type;
+  typedef std::pair<const K, V> value_type;
+  typedef typename base::iterator iterator;
+  typedef typename base::const_iterator const_iterator;
+
+  btree_multimap(size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+    : base(maxNodeElems, comp, alloc) {}
+
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  btree_multimap(InputIt first, InputIt last, size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+    : base(first, last, maxNodeElems, comp, alloc) {}
+
+  /**
+    * Inserts a key and value pair after any elements with an equivalent key.
+    *
+    * @return an iterator positioned at the inserted element.
+    */
+  iterator insert(const value_type& value);
+  iterator insert(value_type&& value);
+
+  /**
+    * Inserts a key and value pair directly before hint when that keeps the keys in order,
+    * otherwise after any elements with an equivalent key.
+    *
+    * @return an iterator positioned at the inserted element.
+    */
+  iterator insert(const_iterator hint, const value_type& value);
+  iterator insert(const_iterator hint, value_type&& value);
+
+  template <typename... Args>
+  iterator emplace(Args&&... args);
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args);
+};
+
+/*
+* A btree which may hold several equivalent elements.
+*/
+template <typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>, size_t Fanout = 0>
+class btree_multiset : public btree<T, Compare, Alloc, Fanout, void, true> {
+  typedef btree<T, Compare, Alloc, Fanout, void, true> base;
+
+ public:
+  typedef typename base::iterator iterator;
+  typedef typename base::const_iterator const_iterator;
+
+  btree_multiset(size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+    : base(maxNodeElems, comp, alloc) {}
+
+  template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+  btree_multiset(InputIt first, InputIt last, size_t maxNodeElems = 40, const Compare& comp = Compare(), const Alloc& alloc = Alloc())
+    : base(first, last, maxNodeElems, comp, alloc) {}
+
+  //Hinted insertion is as for btree
+  using base::insert;
+
+  /**
+    * Inserts elem after any equivalent elements.
+    *
+    * @return an iterator positioned at the inserted element.
+    */
+  iterator insert(const T& elem);
+  iterator insert(T&& elem);
+
+  template <typename... Args>
+  iterator emplace(Args&&... args);
+};
+
+#include "btree_map.tem"
+
+#endif
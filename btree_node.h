@@ -0,0 +1,470 @@
+#ifndef BTREE_NODE_H
+#define BTREE_NODE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <type_traits>
+
+/**
+ * btree_node, bplus_node, string_node, concurrent_node, versioned_node, btree_pool and btree_pool_allocator.
+ *
+ * Every btree owns a pool which carves nodes and their key and child arrays out of large slabs.
+ * Allocating from the pool is usually a pointer bump, blocks released by erased nodes are kept on
+ * per-size free lists for reuse, and all slabs are handed back to the upstream allocator at once
+ * when the pool is destroyed.
+ *
+ * The pool is independent of the client's allocator type, so nodes (and the iterators walking
+ * them) only depend on the element type.
+*/
+
+class btree_pool {
+public:
+  btree_pool() : slabs(nullptr), freeLists(nullptr), cursor(nullptr), remaining(0), nextSlabBytes(kMinSlabBytes), held(0) {}
+  virtual ~btree_pool() {}
+
+  //Allocate and release blocks of a given size
+  void* allocate(size_t bytes);
+  void deallocate(void *p, size_t bytes);
+
+  //Return every slab to the upstream allocator, invalidating all blocks
+  void release();
+
+  //Bytes of the slabs currently held from the upstream allocator
+  size_t bytesHeld() const { return held; }
+
+protected:
+  //Upstream slab allocation, implemented by btree_alloc_pool for the client's allocator
+  virtual void* allocateSlab(size_t bytes) = 0;
+  virtual void deallocateSlab(void *p, size_t bytes) = 0;
+
+private:
+  //Each slab starts with a header linking it to the previously allocated slab
+  struct Slab {
+    Slab *next;
+    size_t bytes;
+  };
+
+  //Released blocks are threaded through their own storage
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  //One free list per block size, the lists themselves are carved from the slabs
+  struct FreeList {
+    size_t bytes;
+    FreeBlock *head;
+    FreeList *next;
+  };
+
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+  static constexpr size_t kMinSlabBytes = 1024;  //slabs start small so empty trees stay cheap
+  static constexpr size_t kMaxSlabBytes = 64 * 1024;  //and double up to this size as the tree grows
+
+  Slab *slabs;
+  FreeList *freeLists;
+  char *cursor;  //next free byte of the current slab
+  size_t remaining;  //bytes left in the current slab
+  size_t nextSlabBytes;
+  size_t held;  //total bytes of every slab
+
+  //Helper functions
+  static size_t roundUp(size_t bytes);
+  void* bump(size_t bytes);
+  FreeList* freeListFor(size_t bytes);
+};
+
+/*
+* A pool drawing its slabs from a client supplied allocator, such as std::allocator
+* or a std::pmr::polymorphic_allocator wrapping a memory resource.
+*/
+template <typename Alloc>
+class btree_alloc_pool : public btree_pool {
+public:
+  explicit btree_alloc_pool(const Alloc& alloc) : alloc(alloc) {}
+  ~btree_alloc_pool() { release(); }
+
+  //Returns a copy of the allocator slabs are obtained from
+  Alloc get_allocator() const { return Alloc(alloc); }
+
+protected:
+  void* allocateSlab(size_t bytes) override;
+  void deallocateSlab(void *p, size_t bytes) override;
+
+private:
+  typename std::allocator_traits<Alloc>::template rebind_alloc<std::max_align_t> alloc;
+};
+
+/*
+* Standard allocator interface over a btree_pool, used for node key and child arrays.
+* Moving or swapping a container carries its pool along, copying a container keeps the destination's pool.
+*/
+template <typename U>
+class btree_pool_allocator {
+public:
+  typedef U value_type;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  explicit btree_pool_allocator(btree_pool *pool) : pool(pool) {}
+
+  template <typename V>
+  btree_pool_allocator(const btree_pool_allocator<V>& other) : pool(other.pool) {}
+
+  U* allocate(size_t n) { return static_cast<U*>(pool->allocate(n * sizeof(U))); }
+  void deallocate(U *p, size_t n) { pool->deallocate(p, n * sizeof(U)); }
+
+  template <typename V>
+  bool operator==(const btree_pool_allocator<V>& other) const { return pool == other.pool; }
+  template <typename V>
+  bool operator!=(const btree_pool_allocator<V>& other) const { return pool != other.pool; }
+
+  btree_pool *pool;
+};
+
+/*
+* The node capacity of a tree. A non-zero Fanout fixes the capacity at compile time, so it costs no storage
+* and every size check against it is a constant. A Fanout of 0 holds the capacity chosen at runtime.
+*/
+template <size_t Fanout>
+struct btree_fanout {
+  static_assert(Fanout >= 2, "a node must be able to hold at least two elements");
+
+  explicit btree_fanout(size_t) {}
+  static constexpr size_t maxElements() { return Fanout; }
+};
+
+template <>
+struct btree_fanout<0> {
+  //Nodes are split around their median, so must be able to hold at least two elements
+  explicit btree_fanout(size_t maxElements) : value(std::max<size_t>(maxElements, 2)) {}
+  size_t maxElements() const { return value; }
+
+  size_t value;
+};
+
+/*
+* Default compile time capacity for elements of type T, filling eight 64 byte cache lines with keys.
+* Such a node is also searched in one pass by the vector key search (see btree_search.h).
+*/
+template <typename T>
+struct btree_default_fanout : std::integral_constant<size_t, std::max<size_t>(512 / sizeof(T), 4)> {};
+
+template <typename T, typename Mapped = void> struct btree_node;
+
+/*
+* The mapped values of a map node, held in their own array parallel to the keys so the keys stay
+* densely packed for searching. Set nodes (Mapped = void) hold no values and take no space for them.
+*/
+template <typename Mapped>
+struct btree_node_values {
+  btree_node_values(btree_pool *pool, size_t maxElements) : values(btree_pool_allocator<Mapped>(pool)) {
+    values.reserve(maxElements + 1);
+  }
+
+  std::vector<Mapped, btree_pool_allocator<Mapped> > values;  //values[i] is mapped to keys[i]
+};
+
+template <>
+struct btree_node_values<void> {
+  btree_node_values(btree_pool*, size_t) {}
+};
+
+/*
+* A node stores its elements in one contiguous sorted array of values.
+* Child links live in a parallel array: child i holds the values between keys[i - 1] and keys[i],
+* giving n + 1 children for n keys. Leaf nodes have no child array at all, and all leaves share the same depth.
+* Each node is aware of its parent node and its slot within it to simplify later traversal algorithms.
+*
+* Map nodes also hold a mapped value per key (see btree_node_values). The tree moves elements between nodes
+* through the slot operations below, which keep each key and its mapped value together.
+*/
+template <typename T, typename Mapped>
+struct btree_node : btree_node_values<Mapped> {
+  //Node constructor, reserving room for the one value a node may temporarily overflow by
+  btree_node(btree_node *p, btree_pool *pool, size_t maxElements)
+    : btree_node_values<Mapped>(pool, maxElements), parent(p), parentSlot(0), subtreeSize(0),
+      keys(btree_pool_allocator<T>(pool)), children(btree_pool_allocator<btree_node*>(pool)) {
+    keys.reserve(maxElements + 1);
+  }
+
+  //Whether this node holds mapped values alongside its keys
+  static constexpr bool hasValues = !std::is_void<Mapped>::value;
+
+  //Whether destroying this node's keys and mapped values can be skipped
+  static constexpr bool triviallyDestructible = std::is_trivially_destructible<T>::value &&
+    std::is_trivially_destructible<typename std::conditional<hasValues, Mapped, T>::type>::value;
+
+  //Construct a key, and its mapped value from args, at slot pos
+  template <typename K, typename... Args>
+  void emplaceSlot(size_t pos, K&& key, Args&&... args);
+
+  //Move slot fromPos of node from into slot pos, either over the existing slot or as a new one
+  void moveSlot(size_t pos, btree_node& from, size_t fromPos);
+  void insertSlot(size_t pos, btree_node& from, size_t fromPos);
+
+  //Move slots [first, last) of node from onto the end of this node
+  void appendSlots(btree_node& from, size_t first, size_t last);
+
+  //Remove slots [first, last)
+  void eraseSlots(size_t first, size_t last);
+
+  //Replace every slot with those of node from, which are moved or copied
+  void takeSlots(btree_node& from);
+  void copySlots(const btree_node& from);
+
+  //Exchange every slot with those of node other, each node keeping the other's reserved arrays
+  void swapSlots(btree_node& other);
+
+  //Remove every slot
+  void clearSlots();
+
+  //The slot of this (non-root) node within its parent's child links
+  size_t slot() const { return parentSlot; }
+
+  //Point the child links from slot 'from' onwards back at this node, recording their new slots.
+  //Called whenever child links are added, removed or shifted.
+  void adoptChildren(size_t from = 0) {
+    for (size_t i = from; i < children.size(); ++i) {
+      children[i]->parent = this;
+      children[i]->parentSlot = i;
+    }
+  }
+
+  //Recompute subtreeSize from the keys and the subtree sizes of the children
+  void recount();
+
+  //Add delta to the subtree size of this node and every node above it, after an element is added or removed below
+  void resizePath(ptrdiff_t delta);
+
+  //The number of elements in the tree ordered before slot pos of this node, where the slot past the root's last key is end()
+  size_t position(size_t pos) const;
+
+  //The node and slot of the element at index of the subtree below this node, or the slot past its last key when index is its size
+  std::pair<const btree_node*, size_t> locate(size_t index) const;
+
+  //Structures
+  btree_node *parent;
+  size_t parentSlot;  //index of this node in parent->children, so iterators climb in O(1)
+  size_t subtreeSize;  //number of elements in this node and every node below it, so positions are found in O(log n)
+  std::vector<T, btree_pool_allocator<T> > keys;  //sorted values stored in this node
+  std::vector<btree_node*, btree_pool_allocator<btree_node*> > children;  //empty for leaf nodes, otherwise keys.size() + 1 links
+};
+
+/*
+* A B+-tree node. Leaves hold the elements and are doubly linked in order, so scans walk from leaf to leaf.
+* Internal nodes only hold separator keys: child i holds the values not less than keys[i - 1] and less than keys[i].
+* As in btree_node, child links live in a parallel array which is empty for leaves.
+*/
+template <typename T>
+struct bplus_node {
+  //Node constructor, reserving room for the one value a node may temporarily overflow by
+  bplus_node(bplus_node *p, btree_pool *pool, size_t maxElements)
+    : parent(p), parentSlot(0), prev(nullptr), next(nullptr),
+      keys(btree_pool_allocator<T>(pool)), children(btree_pool_allocator<bplus_node*>(pool)) {
+    keys.reserve(maxElements + 1);
+  }
+
+  //Leaves are the nodes without child links
+  bool leaf() const { return children.empty(); }
+
+  //The slot of this (non-root) node within its parent's child links
+  size_t slot() const { return parentSlot; }
+
+  //Point the child links from slot 'from' onwards back at this node, recording their new slots.
+  //Called whenever child links are added, removed or shifted.
+  void adoptChildren(size_t from = 0) {
+    for (size_t i = from; i < children.size(); ++i) {
+      children[i]->parent = this;
+      children[i]->parentSlot = i;
+    }
+  }
+
+  //Structures
+  bplus_node *parent;
+  size_t parentSlot;  //index of this node in parent->children
+  bplus_node *prev;  //previous and next leaves in order, null for internal nodes and at either end
+  bplus_node *next;
+  std::vector<T, btree_pool_allocator<T> > keys;  //elements in a leaf, separator keys in an internal node
+  std::vector<bplus_node*, btree_pool_allocator<bplus_node*> > children;  //empty for leaf nodes, otherwise keys.size() + 1 links
+};
+
+/*
+* A B+-tree node for string keys, linked and split as a bplus_node is, which packs its keys into a single byte buffer.
+* The buffer starts with the longest prefix shared by every key of the node, stored once, followed by each key's
+* remaining suffix. offsets[i] is where suffix i starts and offsets[size()] is the end of the buffer, so keys
+* cost their distinct bytes plus one offset each rather than a std::string object apiece.
+*
+* The prefix is kept as long as possible: it shrinks when a key sharing less of it arrives and grows back when the
+* keys that limited it leave. Searches compare a probe against the prefix once, then only against suffixes.
+*/
+struct string_node {
+  string_node(string_node *p, btree_pool *pool, size_t maxElements)
+    : parent(p), parentSlot(0), prev(nullptr), next(nullptr), prefixLength(0),
+      bytes(btree_pool_allocator<char>(pool)), offsets(btree_pool_allocator<uint32_t>(pool)),
+      children(btree_pool_allocator<string_node*>(pool)) {
+    offsets.reserve(maxElements + 2);
+    offsets.push_back(0);
+  }
+
+  //Number of keys held
+  size_t size() const { return offsets.size() - 1; }
+  bool empty() const { return size() == 0; }
+
+  //The shared prefix, the part of key i following it, and key i in full
+  std::string_view prefix() const { return std::string_view(bytes.data(), prefixLength); }
+  std::string_view suffix(size_t i) const { return std::string_view(bytes.data() + offsets[i], offsets[i + 1] - offsets[i]); }
+  std::string key(size_t i) const;
+
+  //Slot of the first key not less than (or greater than) key
+  size_t lowerBound(std::string_view key) const;
+  size_t upperBound(std::string_view key) const;
+
+  //Insert key at slot pos, which must keep the keys in order
+  void insert(size_t pos, std::string_view key);
+
+  //Remove keys [first, last)
+  void erase(size_t first, size_t last);
+
+  //Append keys [first, last) of node from, which must be ordered after the keys of this node
+  void append(const string_node& from, size_t first, size_t last);
+
+  //Leaves are the nodes without child links
+  bool leaf() const { return children.empty(); }
+
+  //The slot of this (non-root) node within its parent's child links
+  size_t slot() const { return parentSlot; }
+
+  //Point the child links from slot 'from' onwards back at this node, recording their new slots.
+  //Called whenever child links are added, removed or shifted.
+  void adoptChildren(size_t from = 0) {
+    for (size_t i = from; i < children.size(); ++i) {
+      children[i]->parent = this;
+      children[i]->parentSlot = i;
+    }
+  }
+
+  //Structures
+  string_node *parent;
+  size_t parentSlot;  //index of this node in parent->children
+  string_node *prev;  //previous and next leaves in order, null for internal nodes and at either end
+  string_node *next;
+  size_t prefixLength;  //length of the shared prefix at the start of bytes
+  std::vector<char, btree_pool_allocator<char> > bytes;  //the prefix followed by every suffix in key order
+  std::vector<uint32_t, btree_pool_allocator<uint32_t> > offsets;  //size() + 1 suffix boundaries within bytes
+  std::vector<string_node*, btree_pool_allocator<string_node*> > children;  //empty for leaf nodes, otherwise size() + 1 links
+
+private:
+  //Length of the longest prefix shared by a and b
+  static size_t commonLength(std::string_view a, std::string_view b);
+
+  //Rewrite the buffer around a new prefix length, which every key must share
+  void setPrefixLength(size_t length);
+};
+
+/*
+* The optimistic lock of a concurrent_node: a version counter whose lowest bit is set while a writer holds the node.
+* Readers never write to it. They note the version before reading a node and check it is unchanged afterwards,
+* retrying whatever they read if a writer got in between. A writer upgrades a version it read to the lock, so it
+* only locks a node no one has changed since, and unlocking moves the version on.
+*/
+class btree_version_lock {
+public:
+  //The current version once no writer holds the node, waiting for any writer to finish
+  uint64_t readVersion() const;
+
+  //Whether the node is unchanged since version was read, so everything read from it since is consistent
+  bool validate(uint64_t version) const;
+
+  //Take the write lock, as long as the node is unchanged since version was read
+  bool upgrade(uint64_t version);
+  void writeUnlock() { version.fetch_add(1, std::memory_order_release); }
+
+private:
+  std::atomic<uint64_t> version{0};
+};
+
+/*
+* A node of a concurrent_btree, a B+-tree whose nodes have a fixed capacity of Fanout keys. Leaves hold the
+* elements and link to the next leaf for scans. Internal nodes hold count separators and count + 1 children,
+* child i holding the elements not greater than keys[i], and greater than keys[i - 1].
+*
+* Readers look at nodes while writers change them, validating what they read against the node's lock, so keys,
+* counts and links are only ever read as a snapshot to be discarded if the lock's version has moved. Nodes are
+* never freed while the tree is in use, so a stale link still leads to a node.
+*
+* Counts and links are relaxed atomics, read and written through the accessors below, so racing on them is
+* well defined and the lock's fences order them. Keys are trivially copyable elements copied as they are, as
+* the data of a seqlock is, and a key read while it was written is discarded with the rest of the read.
+*/
+template <typename T, size_t Fanout>
+struct concurrent_node {
+  explicit concurrent_node(bool leaf) : count(0), leaf(leaf) {}
+
+  //Elements in a leaf, separator keys in an internal node
+  size_t size() const { return count.load(std::memory_order_relaxed); }
+  void resize(size_t n) { count.store(static_cast<uint32_t>(n), std::memory_order_relaxed); }
+
+  btree_version_lock lock;
+  std::atomic<uint32_t> count;
+  const bool leaf;
+  T keys[Fanout];
+};
+
+template <typename T, size_t Fanout>
+struct concurrent_leaf : concurrent_node<T, Fanout> {
+  concurrent_leaf() : concurrent_node<T, Fanout>(true), next(nullptr) {}
+
+  //The next leaf in order, null for the last
+  concurrent_leaf* successor() const { return next.load(std::memory_order_relaxed); }
+  void link(concurrent_leaf *leaf) { next.store(leaf, std::memory_order_relaxed); }
+
+  std::atomic<concurrent_leaf*> next;
+};
+
+template <typename T, size_t Fanout>
+struct concurrent_inner : concurrent_node<T, Fanout> {
+  concurrent_inner() : concurrent_node<T, Fanout>(false) {
+    for (auto& child : children)
+      child.store(nullptr, std::memory_order_relaxed);
+  }
+
+  concurrent_node<T, Fanout>* child(size_t i) const { return children[i].load(std::memory_order_relaxed); }
+  void link(size_t i, concurrent_node<T, Fanout> *node) { children[i].store(node, std::memory_order_relaxed); }
+
+  std::atomic<concurrent_node<T, Fanout>*> children[Fanout + 1];
+};
+
+/*
+* A node of a versioned_btree, a B+-tree whose nodes are never changed once a version holding them is published.
+* A write copies the nodes on its path and links the copies into a new version, so nodes are shared between all
+* the versions they are part of, and need no parent or sibling links.
+*
+* A leaf holds count elements. An internal node holds count separators and count + 1 children, child i holding
+* the elements not less than keys[i - 1] and less than keys[i], as in a bplus_node.
+*/
+template <typename T, size_t Fanout>
+struct versioned_node {
+  explicit versioned_node(bool leaf = true) : count(0), leaf(leaf) {}
+
+  uint32_t count;
+  const bool leaf;
+  T keys[Fanout];
+};
+
+template <typename T, size_t Fanout>
+struct versioned_inner : versioned_node<T, Fanout> {
+  versioned_inner() : versioned_node<T, Fanout>(false), children() {}
+
+  const versioned_node<T, Fanout> *children[Fanout + 1];
+};
+
+#include "btree_node.tem"
+
+#endif
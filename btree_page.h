@@ -0,0 +1,93 @@
+#ifndef BTREE_PAGE_H
+#define BTREE_PAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * The paged file format written and mapped by mapped_btree.
+ *
+ * A file is a sequence of fixed size pages. Page 0 holds a btree_file_header describing the rest.
+ * The elements are stored in order in leaf pages, which follow the header page contiguously and
+ * are all full apart from the last. Internal pages come after the leaves, level by level up to the
+ * root, holding separator keys and the page numbers of their children as in a bplus_tree.
+ *
+ * Elements are stored as their raw bytes, so only trivially copyable types can be paged, and a file
+ * can only be read on a machine with the same element size, alignment and byte order as its writer.
+ * Page contents are addressed by offsets from the page itself or page numbers, never by pointers,
+ * so a file can be mapped at any address and used without any deserialization.
+*/
+
+/*
+* Start of every page. Leaves link to their neighbours by byte offsets from the page itself,
+* which are zero at either end.
+*/
+struct btree_page_header {
+  uint32_t count;  //elements in a leaf, separator keys in an internal page
+  uint32_t level;  //0 for leaves, one more than its children for internal pages
+  int64_t prev;
+  int64_t next;
+};
+
+/*
+* Page 0 of a file
+*/
+struct btree_file_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t pageSize;
+  uint32_t elementSize;
+  uint32_t elementAlign;
+  uint64_t size;  //number of elements
+  uint64_t pages;  //including this header page
+  uint64_t root;  //page number of the root, 0 for an empty tree
+  uint64_t firstLeaf;
+  uint64_t lastLeaf;
+  uint32_t height;
+};
+
+/*
+* Where keys and child page numbers lie within a page of a given size, and how many fit.
+* A leaf holds leafCapacity elements. An internal page holds up to internalCapacity keys
+* and one more child page number than keys.
+*/
+template <typename T>
+struct btree_page_layout {
+  static constexpr size_t roundUp(size_t bytes, size_t alignment) { return (bytes + alignment - 1) / alignment * alignment; }
+
+  static constexpr size_t keysOffset = roundUp(sizeof(btree_page_header), alignof(T));
+
+  explicit btree_page_layout(size_t pageSize) : pageSize(pageSize) {
+    if (pageSize % alignof(T) != 0 || pageSize % alignof(btree_file_header) != 0)
+      throw std::invalid_argument("btree_page_layout: page size is not a multiple of the element alignment");
+
+    if (pageSize < sizeof(btree_file_header) || pageSize < keysOffset + sizeof(T))
+      throw std::invalid_argument("btree_page_layout: page size too small for a header");
+
+    leafCapacity = (pageSize - keysOffset) / sizeof(T);
+    internalCapacity = (pageSize - keysOffset) / (sizeof(T) + sizeof(uint32_t));
+
+    //Child page numbers follow the keys, after the room the largest internal page needs
+    while (internalCapacity > 0 && childrenEnd(internalCapacity) > pageSize) {
+      --internalCapacity;
+    }
+
+    if (internalCapacity < 1)
+      throw std::invalid_argument("btree_page_layout: page size too small for two children per page");
+
+    childrenOffset = roundUp(keysOffset + internalCapacity * sizeof(T), alignof(uint32_t));
+  }
+
+  //End of the child page numbers of an internal page holding up to capacity keys
+  static constexpr size_t childrenEnd(size_t capacity) {
+    return roundUp(keysOffset + capacity * sizeof(T), alignof(uint32_t)) + (capacity + 1) * sizeof(uint32_t);
+  }
+
+  size_t pageSize;
+  size_t leafCapacity;
+  size_t internalCapacity;
+  size_t childrenOffset;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef BTREE_PARALLEL_H
+#define BTREE_PARALLEL_H
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * Running the work of a bulk build or a scan on several threads, with nothing but std::thread.
+ *
+ * Each call starts its own threads and joins them before returning, the calling thread taking a share
+ * of the work. Work is split into tasks which the threads claim one at a time, so threads finishing
+ * early take on tasks the others have not reached. An exception thrown by a task stops the threads
+ * claiming further tasks and is rethrown once they have all been joined.
+ *
+ * A thread count of 0 means one thread per hardware thread.
+*/
+
+//The number of threads to run for a requested count, 0 asking for one per hardware thread
+inline size_t btree_thread_count(size_t threads);
+
+//Call fn(task) for every task in [0, tasks), on up to threads threads
+template <typename F>
+void btree_parallel_run(size_t tasks, size_t threads, F fn);
+
+//Stable sort [first, last) by less: runs are sorted on threads of their own and then merged pairwise
+template <typename RandomIt, typename Less>
+void btree_parallel_sort(RandomIt first, RandomIt last, Less less, size_t threads);
+
+/**
+  * Calls fn with every element of tree, handing disjoint ranges of the
+  * tree (see btree::split) to threads which walk them concurrently. Each
+  * element is visited exactly once, in order within a range, but ranges
+  * are visited in no particular order.
+  *
+  * The tree must not be modified until parallel_for_each returns, and fn
+  * must be safe to call from several threads at once.
+  *
+  * @param tree the tree to visit the elements of
+  * @param fn a callable taking a const reference to an element
+  * @param threads the number of threads to use, 0 for one per hardware thread
+  */
+template <typename Tree, typename F>
+void parallel_for_each(const Tree& tree, F fn, size_t threads = 0);
+
+#include "btree_parallel.tem"
+
+#endif
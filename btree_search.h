@@ -0,0 +1,73 @@
+#ifndef BTREE_SEARCH_H
+#define BTREE_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "btree_stats.h"
+
+//Build time selection of the vector search, define BTREE_NO_SIMD to always use binary search
+#if !defined(BTREE_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+#define BTREE_SIMD_SEARCH 1
+#include <immintrin.h>
+#else
+#define BTREE_SIMD_SEARCH 0
+#endif
+
+/**
+ * Searching within a node's sorted key array.
+ *
+ * btree_lower_bound and btree_upper_bound return the slot of the first key not ordered before
+ * (or ordered after) an element. By default this is a binary search using Compare.
+ *
+ * For int, long, float and double keys ordered by std::less (or the transparent std::less<>), the node is instead searched with
+ * vector compares: the slot is the number of keys ordered before the element, counted a whole
+ * register at a time with compare and movemask. Large nodes are first narrowed down to a small window
+ * by binary search. Which instruction set is used is chosen when the client is compiled, AVX2
+ * when enabled (e.g. -mavx2 or -march=native), otherwise SSE2, with binary search as the fallback
+ * for other platforms. SSE2 has no 64 bit integer compare, so without SSE4.2 (-msse4.2) long keys are
+ * compared a half at a time, which is slower than the single compare SSE4.2 offers but still branch free.
+*/
+
+//Slot of the first key in [keys, keys + n) not ordered before elem.
+//MaxKeys, when non-zero, is a compile time bound on n which lets fixed size nodes skip narrowing.
+//elem may be of any type K that comp can order against T, only keys searched as T use vector compares.
+template <size_t MaxKeys = 0, typename T, typename K, typename Compare>
+size_t btree_lower_bound(const T *keys, size_t n, const K& elem, const Compare& comp);
+
+//Slot of the first key in [keys, keys + n) ordered after elem
+template <size_t MaxKeys = 0, typename T, typename K, typename Compare>
+size_t btree_upper_bound(const T *keys, size_t n, const K& elem, const Compare& comp);
+
+/*
+* Whether keys of type T ordered by Compare are searched with vector compares in this build
+*/
+template <typename T, typename Compare>
+struct btree_simd_search : std::integral_constant<bool, BTREE_SIMD_SEARCH &&
+  (std::is_same<Compare, std::less<T> >::value || std::is_same<Compare, std::less<> >::value) &&
+  (std::is_same<T, float>::value || std::is_same<T, double>::value ||
+   (std::is_integral<T>::value && std::is_signed<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)))> {};
+
+//Count the keys in [keys, keys + n) less than elem, or not greater than elem when Inclusive
+template <bool Inclusive, typename T>
+size_t btree_simd_count(const T *keys, size_t n, T elem);
+
+#if BTREE_SIMD_SEARCH
+//Lanes of signed 64 bit integers in a greater than b set to all ones, the others to zero
+inline __m128i btree_cmpgt_epi64(__m128i a, __m128i b);
+#endif
+
+//Slot of the first key not less than (or, when Inclusive, greater than) elem, narrowing large nodes down before counting
+template <bool Inclusive, size_t MaxKeys, typename T>
+size_t btree_simd_bound(const T *keys, size_t n, T elem);
+
+//Hint that the bytes at [p, p + bytes) are about to be read, issuing a prefetch per cache line.
+//Does nothing where the compiler offers no prefetch builtin.
+inline void btree_prefetch(const void *p, size_t bytes);
+
+#include "btree_search.tem"
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef BTREE_STATS_H
+#define BTREE_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Instrumentation of a btree: its shape, measured on demand by btree::stats(), and counters of the work
+ * done by searches, insertions, removals and iterator steps.
+ *
+ * The counters cost nothing unless enabled at build time by defining BTREE_COUNTERS (e.g. -DBTREE_COUNTERS),
+ * which must then be defined for every translation unit of a program alike. Each thread counts into counters
+ * of its own, read and reset through btree_counters::local(), so counting never contends between threads.
+*/
+
+//The shape of a btree, see btree::stats()
+struct btree_stats {
+  size_t size;  //number of elements
+  size_t height;  //levels of nodes, 0 for an empty tree
+  size_t nodes;  //nodes of every level, the root included
+  size_t leaves;
+  size_t maxNodeElems;  //the most elements a node may hold
+  double fill;  //average fraction of maxNodeElems held by a node
+  double leafFill;  //the same over the leaves alone, which hold most of the elements
+  size_t nodeBytes;  //bytes of the nodes themselves and the arrays they reserve
+  size_t poolBytes;  //bytes the tree's pool holds from its allocator, including blocks free for reuse
+};
+
+//Work counted by the calling thread while BTREE_COUNTERS is defined
+struct btree_counters {
+  uint64_t comparisons = 0;  //keys compared by node searches, each key of a vector compare counting once
+  uint64_t nodesVisited = 0;  //nodes searched on the way down by finds, bounds and insertions
+  uint64_t splits = 0;  //nodes split by insertions
+  uint64_t merges = 0;  //nodes merged by removals
+  uint64_t iteratorSteps = 0;  //iterator increments and decrements
+
+  void reset() { *this = btree_counters(); }
+
+  //The calling thread's counters
+  static btree_counters& local() {
+    static thread_local btree_counters counters;
+    return counters;
+  }
+};
+
+#ifdef BTREE_COUNTERS
+
+#define BTREE_COUNT(counter, n) (btree_counters::local().counter += (n))
+
+//A comparator counting each comparison it makes into the calling thread's counters
+template <typename Compare>
+struct btree_counting_compare {
+  template <typename A, typename B>
+  bool operator()(const A& a, const B& b) const {
+    ++btree_counters::local().comparisons;
+    return comp(a, b);
+  }
+
+  const Compare& comp;
+};
+
+template <typename Compare>
+btree_counting_compare<Compare> btree_counted(const Compare& comp) { return btree_counting_compare<Compare>{comp}; }
+
+#else
+
+#define BTREE_COUNT(counter, n) ((void)0)
+
+//Without counters, comparisons are made with the comparator itself
+template <typename Compare>
+const Compare& btree_counted(const Compare& comp) { return comp; }
+
+#endif
+
+#endif
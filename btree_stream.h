@@ -0,0 +1,182 @@
+#ifndef BTREE_STREAM_H
+#define BTREE_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <type_traits>
+
+/**
+ * The binary stream format written by btree::save and read back by btree::load.
+ *
+ * A stream starts with a btree_stream_header recording the element types and the node size
+ * of the saved tree. The elements follow in order, encoded by btree_codec, in blocks of up to
+ * btree_stream_writer::blockBytes. Each block is prefixed by its element and byte counts, and
+ * an empty block ends the stream, followed by a btree_stream_trailer holding the element total
+ * and a checksum of every block. Neither side ever holds more than one block, so trees of any
+ * size are saved and loaded in a single pass with bounded memory.
+ *
+ * Fixed size fields are stored as their raw bytes, so a stream can only be loaded on a machine
+ * with the same byte order and type sizes as the one that saved it.
+*/
+
+struct btree_stream_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t keySize;  //sizeof the element or key type
+  uint32_t mappedSize;  //sizeof the mapped type, 0 for sets
+  uint32_t multi;  //1 if equivalent elements may repeat
+  uint64_t maxNodeElems;
+
+  //The largest node size a stream is trusted to record, anything larger is taken as corruption
+  static constexpr uint64_t maxNodeElemsLimit = 1 << 20;
+};
+
+//The type sizes recorded in a header, where a set's absent mapped type has size 0
+template <typename T>
+struct btree_stream_size : std::integral_constant<uint32_t, sizeof(T)> {};
+
+template <>
+struct btree_stream_size<void> : std::integral_constant<uint32_t, 0> {};
+
+struct btree_stream_trailer {
+  uint64_t size;  //number of elements
+  uint64_t checksum;
+};
+
+/*
+* A running 64 bit checksum of a byte stream, folding in eight bytes at a time in the manner of FNV-1a.
+* Each update must be given the same spans in the same order for two checksums to agree.
+*/
+class btree_checksum {
+ public:
+  void update(const char *data, size_t bytes);
+  uint64_t value() const { return hash; }
+
+ private:
+  uint64_t hash = 14695981039346656037ull;
+};
+
+/*
+* How a value is written to and read from a stream. Trivially copyable types are stored as their bytes,
+* strings as their length followed by their characters, and pairs as their first then second value.
+* Other element types can be saved by specialising btree_codec.
+*/
+template <typename T>
+struct btree_codec {
+  static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable elements are saved as their bytes, specialise btree_codec for others");
+
+  static void encode(std::string& out, const T& value);
+  static void decode(const char*& in, const char *end, T& value);
+};
+
+template <typename C, typename Traits, typename A>
+struct btree_codec<std::basic_string<C, Traits, A> > {
+  static void encode(std::string& out, const std::basic_string<C, Traits, A>& value);
+  static void decode(const char*& in, const char *end, std::basic_string<C, Traits, A>& value);
+};
+
+template <typename First, typename Second>
+struct btree_codec<std::pair<First, Second> > {
+  static void encode(std::string& out, const std::pair<First, Second>& value);
+  static void decode(const char*& in, const char *end, std::pair<First, Second>& value);
+};
+
+/*
+* Writes the header, then buffers encoded elements and writes them out a block at a time.
+*/
+class btree_stream_writer {
+ public:
+  //Blocks are written once they reach this size
+  static constexpr size_t blockBytes = 64 * 1024;
+
+  btree_stream_writer(std::ostream& os, btree_stream_header header);
+
+  //Encode elements onto the end of buffer(), then call added() once for each
+  std::string& buffer() { return block; }
+  void added();
+
+  //Write the last block, the end of the stream and the trailer
+  void finish();
+
+ private:
+  std::ostream& os;
+  std::string block;
+  uint32_t blockElements = 0;
+  uint64_t size = 0;
+  btree_checksum checksum;
+
+  void flush();
+  void write(const void *data, size_t bytes);
+};
+
+/*
+* Reads the header, then reads blocks one at a time as their elements are decoded.
+* The trailer is read and checked once the end of the stream is reached.
+*/
+class btree_stream_reader {
+ public:
+  explicit btree_stream_reader(std::istream& is);
+
+  const btree_stream_header& header() const { return head; }
+
+  //Decode the next element into value, returning false at the end of the stream
+  template <typename Value>
+  bool next(Value& value);
+
+ private:
+  std::istream& is;
+  btree_stream_header head;
+  std::string block;
+  const char *cursor = nullptr;
+  const char *end = nullptr;
+  uint32_t blockElements = 0;  //left to decode in the current block
+  uint64_t size = 0;
+  btree_checksum checksum;
+
+  //Read the next block, or check the trailer and return false at the end of the stream
+  bool readBlock();
+  void read(void *data, size_t bytes);
+};
+
+/*
+* An input iterator over the elements of a stream, so a stream can be bulk loaded like any other range.
+* A default constructed iterator is the end of the stream.
+*/
+template <typename Value>
+class btree_stream_iterator {
+ public:
+  typedef ptrdiff_t difference_type;
+  typedef std::input_iterator_tag iterator_category;
+  typedef Value value_type;
+  typedef const Value* pointer;
+  typedef const Value& reference;
+
+  btree_stream_iterator() : reader(nullptr) {}
+  explicit btree_stream_iterator(btree_stream_reader& reader) : reader(&reader) { ++*this; }
+
+  reference operator*() const { return value; }
+  pointer operator->() const { return &value; }
+
+  btree_stream_iterator<Value>& operator++() {
+    if (!reader->next(value))
+      reader = nullptr;
+
+    return *this;
+  }
+
+  //Only the end of the stream compares equal to another iterator
+  bool operator==(const btree_stream_iterator<Value>& other) const { return reader == other.reader; }
+  bool operator!=(const btree_stream_iterator<Value>& other) const { return !operator==(other); }
+
+ private:
+  btree_stream_reader *reader;
+  Value value;
+};
+
+#include "btree_stream.tem"
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * The concurrent_btree is a B+-tree holding an ordered set of unique
+ * elements which any number of threads may search and modify at once,
+ * without a lock around the tree.
+ *
+ * Nodes carry optimistic version locks (see btree_version_lock).
+ * Readers descend without writing to any shared memory: each node is
+ * read, then its version checked to be unchanged, and only then is a
+ * child link followed, so readers never contend for cache lines with
+ * each other. Writers descend the same way and lock just the nodes
+ * they change, a leaf for most insertions and removals, or a node and
+ * its parent while splitting it. A full internal node is split on the
+ * way down, so a split never has to climb further than one parent.
+ * An operation which finds a version moved underneath it restarts.
+ *
+ * Removal takes elements out of their leaf without merging nodes, so
+ * nodes are never freed while the tree is in use, and a reader holding
+ * a stale link always lands on a node. Erase never frees or unlinks a
+ * leaf: leaves emptied by removals stay in place, still walked over by
+ * scans, and fill up again as elements are inserted into their range.
+ *
+ * Nodes are read while they are being written, so elements must be
+ * trivially copyable: a torn read of an element is simply discarded
+ * when the node's version fails to validate. Compare must not mind
+ * being called on such an element first.
+ */
+
+#ifndef CONCURRENT_BTREE_H
+#define CONCURRENT_BTREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+//Include our nodes and node searches
+#include "btree_node.h"
+#include "btree_search.h"
+
+/*
+ * T is the element type, ordered by Compare. All node memory comes from a pool which takes its slabs from an
+ * allocator of type Alloc. Every node holds up to Fanout keys, by default eight cache lines of them.
+*/
+template <typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>,
+          size_t Fanout = btree_default_fanout<T>::value>
+class concurrent_btree {
+  static_assert(std::is_trivially_copyable<T>::value, "elements are read while being written, so must be trivially copyable");
+  static_assert(Fanout >= 3, "a node must be able to hold at least three elements");
+
+ public:
+  /**
+   * Constructs an empty concurrent_btree, a single empty leaf.
+   *
+   * @param comp the ordering used to compare elements
+   * @param alloc the allocator node slabs are obtained from
+   */
+  concurrent_btree(const Compare& comp = Compare(), const Alloc& alloc = Alloc());
+
+  //Threads share one tree in place, so it is neither copied nor moved
+  concurrent_btree(const concurrent_btree&) = delete;
+  concurrent_btree& operator=(const concurrent_btree&) = delete;
+
+  /**
+    * Inserts elem if no equivalent element is present. Safe to call
+    * from any number of threads at once.
+    *
+    * @param elem the element to insert.
+    * @return whether elem was inserted.
+    */
+  bool insert(const T& elem);
+
+  /**
+    * Removes the element equivalent to elem, if present. Safe to call
+    * from any number of threads at once.
+    *
+    * @param elem the element to remove.
+    * @return whether an element was removed.
+    */
+  bool erase(const T& elem);
+
+  /**
+    * Returns whether an element equivalent to elem is present. Safe to
+    * call from any number of threads at once, and writes no shared memory.
+    */
+  bool contains(const T& elem) const;
+
+  /**
+    * Copies up to limit elements, from the first not ordered before from
+    * onwards, in order to out. Each leaf is copied as a consistent
+    * snapshot, but the scan as a whole is not: elements inserted or
+    * removed behind it while it runs may or may not be seen. Leaves
+    * emptied by erase are walked past, so after heavy removal a scan
+    * may visit many leaves for few elements.
+    *
+    * @param from the element to start from.
+    * @param limit the most elements to copy.
+    * @param out an output iterator the elements are copied to.
+    * @return out, positioned after the last element copied.
+    */
+  template <typename OutputIt>
+  OutputIt scan(const T& from, size_t limit, OutputIt out) const;
+
+  /**
+    * Returns the allocator node slabs are obtained from.
+    */
+  Alloc get_allocator() const { return static_cast<const btree_alloc_pool<Alloc>&>(*pool).get_allocator(); }
+
+  /**
+    * Destructor
+    * Returns every node to the allocator a slab at a time. No other thread may be using the tree.
+    */
+  ~concurrent_btree() {}
+
+ private:
+  typedef concurrent_node<T, Fanout> Node;
+  typedef concurrent_leaf<T, Fanout> Leaf;
+  typedef concurrent_inner<T, Fanout> Inner;
+
+  //Ordering of elements
+  Compare comp;
+
+  //Pool every node is allocated from, which only ever grows while the tree is in use. Declared before the nodes so it outlives them.
+  std::mutex poolMutex;
+  std::unique_ptr<btree_pool> pool;
+
+  //The root is replaced by a new root above it when it splits
+  std::atomic<Node*> root;
+
+  //Single attempts at each operation, returning false when a version moved and the operation must restart
+  bool tryInsert(const T& elem, bool& inserted);
+  bool tryErase(const T& elem, bool& erased);
+  bool tryContains(const T& elem, bool& found) const;
+
+  //Descend to the leaf which holds or would hold elem, returning its version and that of its parent (null for a root leaf)
+  bool findLeaf(const T& elem, Leaf*& leaf, uint64_t& version, Inner*& parent, uint64_t& parentVersion) const;
+
+  //Split a full node and link the new node into its parent, or a new root. Both must be write locked.
+  void splitNode(Node *node, Inner *parent);
+
+  //Node searches, bounded by the capacity in case count is read mid change
+  size_t lowerBound(const Node *node, const T& elem) const;
+  size_t upperBound(const Node *node, const T& elem) const;
+
+  //Allocate and construct a node from the pool
+  template <typename N>
+  N* newNode();
+};
+
+#include "concurrent_btree.tem"
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * The mapped_btree serves a read only ordered set of elements straight
+ * from a file in the paged format of btree_page.h, which write() produces
+ * from any btree (or other container iterated in order).
+ *
+ * Opening a mapped_btree maps the file into memory with mmap and does
+ * nothing more, however many elements it holds. Searches descend from
+ * the root page and iterators walk the leaf pages in place, so pages are
+ * only read from disk as they are first touched, and a file mapped by
+ * several processes is held in memory once.
+ *
+ * A file must be searched with the ordering its elements were written in.
+ */
+
+#ifndef MAPPED_BTREE_H
+#define MAPPED_BTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <string>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+//Include our pages and iterators
+#include "btree_page.h"
+#include "mapped_iterator.h"
+#include "btree_search.h"
+
+/*
+ * T is the element type, ordered by Compare.
+*/
+template <typename T, typename Compare = std::less<T> >
+class mapped_btree {
+  static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable elements can be stored in pages");
+
+ public:
+  /**
+   * Opens a file written by write() for elements of type T.
+   *
+   * @param path the file to map.
+   * @param comp the ordering the file's elements were written in.
+   * @throws std::system_error if the file cannot be opened or mapped.
+   * @throws std::runtime_error if the file is not a paged btree of T.
+   */
+  explicit mapped_btree(const std::string& path, const Compare& comp = Compare());
+
+  /**
+   * Move constructor
+   * Takes over the mapping of original, leaving it empty.
+   *
+   * @param original an rvalue reference to a mapped_btree object
+   */
+  mapped_btree(mapped_btree<T, Compare>&& original);
+
+  /**
+   * Move assignment
+   * Unmaps our file and takes over the mapping of rhs, leaving it empty.
+   *
+   * @param rhs an rvalue reference to a mapped_btree object
+   */
+  mapped_btree<T, Compare>& operator=(mapped_btree<T, Compare>&& rhs);
+
+  //A mapping has a single owner
+  mapped_btree(const mapped_btree<T, Compare>&) = delete;
+  mapped_btree<T, Compare>& operator=(const mapped_btree<T, Compare>&) = delete;
+
+  /**
+   * Writes the elements of tree to path as a paged file. Leaves are filled completely,
+   * then each level of internal pages is built on the one below, up to a single root.
+   * The file is written alongside path and renamed over it once complete, so a
+   * mapped_btree opening path sees either the old file or the new one.
+   *
+   * @param tree any container whose iteration yields elements of type T in order.
+   * @param path the file to write.
+   * @param pageSize the size of every page, a multiple of T's alignment.
+   * @throws std::system_error if the file cannot be written.
+   * @throws std::invalid_argument if pageSize cannot hold two elements per page.
+   */
+  template <typename Tree>
+  static void write(const Tree& tree, const std::string& path, size_t pageSize = 4096);
+
+  /** Iterator type definitions **/
+
+  //Elements are read only, so both iterator types are the same
+  typedef mapped_iterator<T> iterator;
+  typedef mapped_iterator<T> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  //begin() and end(), both O(1) as the first and last leaves are known
+  const_iterator begin() const { return const_iterator(head, 0); }
+  const_iterator end() const { return const_iterator(tail, tail != nullptr ? header(tail).count : 0); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  /**
+    * Returns an iterator to the matching element, or end()
+    * if the element could not be found.
+    *
+    * @param elem the client element we are trying to match.
+    * @return an iterator to the matching element, or end().
+    */
+  const_iterator find(const T& elem) const;
+
+  /**
+    * Returns whether an element equivalent to elem is present.
+    */
+  bool contains(const T& elem) const { return find(elem) != end(); }
+
+  /**
+    * Returns an iterator to the first element not ordered before elem,
+    * or end() if every element is ordered before it.
+    */
+  const_iterator lower_bound(const T& elem) const;
+
+  /**
+    * Returns an iterator to the first element ordered after elem,
+    * or end() if no element is ordered after it.
+    */
+  const_iterator upper_bound(const T& elem) const;
+
+  /**
+    * Returns the range of elements equivalent to elem, which is
+    * either empty or holds exactly one element.
+    */
+  std::pair<const_iterator, const_iterator> equal_range(const T& elem) const;
+
+  /**
+    * Returns the number of elements, recorded in the file.
+    */
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  /**
+    * Returns the number of levels of pages, which is 0 for an empty tree.
+    */
+  size_t height() const { return levels; }
+
+  /**
+    * Destructor
+    * Unmaps the file.
+    */
+  ~mapped_btree();
+
+ private:
+  //Ordering of elements
+  Compare comp;
+
+  //The whole file as mapped, or null once moved from
+  const char *base;
+  size_t length;
+
+  //Where keys and children lie in each page
+  btree_page_layout<T> layout;
+
+  //Totals from the file header, along with the root and first and last leaves, null for an empty tree
+  size_t count;
+  size_t levels;
+  const char *root;
+  const char *head;
+  const char *tail;
+
+  //Map path and check it is a paged btree of T, returning its page size
+  size_t map(const std::string& path);
+
+  //Page accessors
+  static const btree_page_header& header(const char *page) { return *reinterpret_cast<const btree_page_header*>(page); }
+  static const T* keys(const char *page) { return reinterpret_cast<const T*>(page + btree_page_layout<T>::keysOffset); }
+  const uint32_t* children(const char *page) const { return reinterpret_cast<const uint32_t*>(page + layout.childrenOffset); }
+  const char* page(uint64_t number) const { return base + number * layout.pageSize; }
+
+  //Locate the leaf page and slot of a lower or upper bound
+  std::pair<const char*, size_t> findBound(const T& elem, bool upper) const;
+};
+
+#include "mapped_btree.tem"
+
+#endif
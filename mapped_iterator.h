@@ -0,0 +1,60 @@
+#ifndef MAPPED_ITERATOR_H
+#define MAPPED_ITERATOR_H
+
+#include <iterator>
+#include <type_traits>
+
+#include "btree_page.h"
+
+/**
+ * mapped_iterator implementation.
+ *
+ * Will allow in-order (from lowest to highest) traversal through a mapped_btree.
+ * As in a bplus_iterator, only the current leaf 'page' and the slot 'pos' within its
+ * elements are stored, and the iterator steps between neighbouring leaves through
+ * the links in their page headers. Elements are read straight from the mapped file,
+ * which is read only, so there is no separate const iterator.
+ *
+*/
+
+template <typename T, typename Compare> class mapped_btree;
+
+template <typename T>
+class mapped_iterator {
+public:
+  template <typename, typename> friend class mapped_btree;
+
+  typedef ptrdiff_t difference_type;
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef const T* pointer;
+  typedef const T& reference;
+
+  bool operator==(const mapped_iterator<T>&) const;
+  bool operator!=(const mapped_iterator<T>& other) const { return !operator==(other); }
+
+  reference operator*() const;
+  pointer operator->() const { return &(operator*()); }
+  mapped_iterator<T>& operator++(); //preinc
+  mapped_iterator<T> operator++(int); //postinc
+  mapped_iterator<T>& operator--(); //predec
+  mapped_iterator<T> operator--(int); //postdec
+
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  mapped_iterator() : page(nullptr), pos(0) {}
+  mapped_iterator(const char *page, size_t pos)
+    : page(page), pos(pos) {}
+
+private:
+  //Store a current leaf page as well as a slot within its elements
+  const char *page;
+  size_t pos;
+
+  const btree_page_header& header() const { return *reinterpret_cast<const btree_page_header*>(page); }
+};
+
+static_assert(std::is_trivially_copyable<mapped_iterator<int> >::value, "mapped_iterator must be trivially copyable");
+
+#include "mapped_iterator.tem"
+
+#endif
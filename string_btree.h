@@ -0,0 +1,247 @@
+/**
+ * The string_btree is a B+-tree holding an ordered set of unique
+ * strings, specialised to store them compactly. Each node packs its
+ * keys into one byte buffer: the prefix every key of the node shares
+ * is stored once, followed by the rest of each key, with an array of
+ * offsets marking where each key starts. Internal nodes route searches
+ * with the shortest separators that divide their children's keys.
+ *
+ * Sorted word lists, where neighbouring keys share long prefixes, take
+ * a fraction of the memory of a btree<std::string>, whose keys each
+ * occupy a std::string object and possibly a heap block besides. Node
+ * searches compare a probe against the shared prefix once and against
+ * the suffixes only from then on.
+ *
+ * Keys are ordered bytewise as std::string orders them. Lookups and
+ * insertion take a std::string_view, so neither string literals nor
+ * substrings need copying to search the tree. Dereferencing an iterator
+ * yields the key as a new std::string.
+ */
+
+#ifndef STRING_BTREE_H
+#define STRING_BTREE_H
+
+#include <iostream>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+#include <new>
+
+//Include our nodes and iterators
+#include "btree_node.h"
+#include "string_iterator.h"
+
+//Add declarations for non-template friends
+template <typename Alloc = std::allocator<char> > class string_btree;
+template <typename Alloc> std::ostream& operator<<(std::ostream& os, const string_btree<Alloc>& tree);
+
+/*
+ * As with btree, all node memory, including each node's packed keys, comes from a pool
+ * which takes its slabs from an allocator of type Alloc.
+*/
+template <typename Alloc>
+class string_btree {
+ public:
+  /**
+   * Constructs an empty string_btree.
+   *
+   * Both leaves and internal nodes hold up to maxNodeElems keys,
+   * which is rounded up to two. The bytes of those keys are not bounded.
+   *
+   * @param maxNodeElems the maximum number of keys
+   *        that can be stored in each node
+   * @param alloc the allocator node slabs are obtained from
+   */
+  string_btree(size_t maxNodeElems = 40, const Alloc& alloc = Alloc());
+
+  /**
+   * Copy constructor
+   * Creates a new tree as a copy of original.
+   *
+   * @param original a const lvalue reference to a string_btree object
+   */
+  string_btree(const string_btree<Alloc>& original);
+
+  /**
+   * Move constructor
+   * Creates a new tree by "stealing" from original.
+   *
+   * @param original an rvalue reference to a string_btree object
+   */
+  string_btree(string_btree<Alloc>&& original);
+
+  /**
+   * Copy assignment
+   * Replaces the contents of this object with a copy of rhs.
+   *
+   * @param rhs a const lvalue reference to a string_btree object
+   */
+  string_btree<Alloc>& operator=(const string_btree<Alloc>& rhs);
+
+  /**
+   * Move assignment
+   * Replaces the contents of this object with the "stolen"
+   * contents of rhs.
+   *
+   * @param rhs an rvalue reference to a string_btree object
+   */
+  string_btree<Alloc>& operator=(string_btree<Alloc>&& rhs);
+
+  /**
+   * Puts the keys of the tree onto the output stream os in order,
+   * separated by space. Should not output any newlines.
+   *
+   * @param os a reference to a C++ output stream
+   * @param tree a const reference to a string_btree object
+   * @return a reference to os
+   */
+  friend std::ostream& operator<< <Alloc> (std::ostream& os, const string_btree<Alloc>& tree);
+
+  /** Iterator type definitions **/
+
+  //Keys are never modified in place, so both iterator types are the same
+  typedef string_iterator iterator;
+  typedef string_iterator const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  //begin() and end(), both O(1) as the first and last leaves are kept
+  const_iterator begin() const { return const_iterator(head, 0); }
+  const_iterator end() const { return const_iterator(tail, tail->size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  /**
+    * Returns an iterator to the matching key, or end()
+    * if the key could not be found.
+    *
+    * @param key the key we are trying to match.
+    * @return an iterator to the matching key, or end().
+    */
+  const_iterator find(std::string_view key) const;
+
+  /**
+    * Returns whether the key is present.
+    */
+  bool contains(std::string_view key) const { return find(key) != end(); }
+
+  /**
+    * Returns an iterator to the first key not ordered before key,
+    * or end() if every key is ordered before it.
+    */
+  const_iterator lower_bound(std::string_view key) const;
+
+  /**
+    * Returns an iterator to the first key ordered after key,
+    * or end() if no key is ordered after it.
+    */
+  const_iterator upper_bound(std::string_view key) const;
+
+  /**
+    * Returns the range of keys equal to key, which is
+    * either empty or holds exactly one key.
+    */
+  std::pair<const_iterator, const_iterator> equal_range(std::string_view key) const;
+
+  /**
+    * Inserts key into the tree if it is not already present.
+    * Iterators into the tree are invalidated by the insertion.
+    *
+    * @param key the key to insert, whose bytes are copied into its leaf.
+    * @return a pair whose first field is an iterator positioned at
+    *         the key and whose second field indicates whether
+    *         key was inserted.
+    */
+  std::pair<iterator, bool> insert(std::string_view key);
+
+  /**
+    * Removes the key at pos. Other iterators into the tree are invalidated.
+    *
+    * @param pos an iterator positioned at a valid key of this tree.
+    * @return an iterator positioned at the key that followed the
+    *         removed key, or end() if it was the last.
+    */
+  iterator erase(const_iterator pos);
+
+  /**
+    * Removes key, if it is present.
+    *
+    * @param key the key to remove.
+    * @return the number of keys removed (0 or 1).
+    */
+  size_t erase(std::string_view key);
+
+  /**
+    * Removes every key, leaving an empty tree.
+    */
+  void clear();
+
+  /**
+    * Returns the allocator node slabs are obtained from.
+    */
+  Alloc get_allocator() const { return static_cast<const btree_alloc_pool<Alloc>&>(*pool).get_allocator(); }
+
+  /**
+    * Returns the number of levels in the tree, which is 0 for an empty tree.
+    * All leaves are at the same depth.
+    */
+  size_t height() const;
+
+  /**
+    * Destructor
+    * Releases every node back to the pool, which returns its slabs to the allocator.
+    */
+  ~string_btree();
+
+ private:
+  typedef string_node Node;
+
+  //Size of each node
+  size_t maxElements;
+
+  //Pool every node is allocated from. Declared before the nodes so it outlives them.
+  std::unique_ptr<btree_pool> pool;
+
+  //The root node, along with the first and last leaves where scans start
+  Node *root;
+  Node *head;
+  Node *tail;
+
+  //Copy the nodes below source into dest, linking up copied leaves in order
+  void copyTree(const Node *source, Node *dest, Node*& lastLeaf);
+
+  //Descend to the leaf which holds or would hold key
+  const Node* findLeaf(std::string_view key) const;
+
+  //Locate the leaf and slot of a lower or upper bound
+  std::pair<const Node*, size_t> findBound(std::string_view key, bool upper) const;
+
+  //The shortest key ordered after every key of left and not after any key of right
+  static std::string separator(const Node *left, const Node *right);
+
+  //Insertion and erase helpers, tracked and trackedPos follow a key in a leaf as keys move
+  Node* splitNode(Node *node, Node*& tracked, size_t& trackedPos);
+  void rebalance(Node *node, Node*& tracked, size_t& trackedPos);
+  void borrowFromLeft(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+  void borrowFromRight(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+  void mergeChildren(Node *parent, size_t slot, Node*& tracked, size_t& trackedPos);
+
+  //Node memory management
+  void deleteChildren(Node *node);
+  Node* newNode(Node *parent);
+  void deleteNode(Node *node);
+};
+
+#include "string_btree.tem"
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef STRING_ITERATOR_H
+#define STRING_ITERATOR_H
+
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "btree_node.h"
+#include "btree_iterator.h"
+
+/**
+ * string_iterator implementation.
+ *
+ * Will allow in-order (from lowest to highest) traversal through a string_btree.
+ * As in a bplus_iterator, only the current leaf 'node' and the slot 'pos' within it are stored.
+ * Keys are packed into their leaf rather than stored as std::string objects, so dereferencing
+ * builds the key from the leaf's shared prefix and the key's suffix and returns it by value.
+ * The keys of a string_btree are never modified in place, so there is no separate const iterator.
+ *
+*/
+
+template <typename Alloc> class string_btree;
+
+class string_iterator {
+public:
+  template <typename> friend class string_btree;
+
+  typedef ptrdiff_t difference_type;
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef std::string value_type;
+  typedef btree_arrow_proxy<std::string> pointer;
+  typedef std::string reference;
+
+  bool operator==(const string_iterator&) const;
+  bool operator!=(const string_iterator& other) const { return !operator==(other); }
+
+  reference operator*() const;
+  pointer operator->() const { return pointer{operator*()}; }
+  string_iterator& operator++(); //preinc
+  string_iterator operator++(int); //postinc
+  string_iterator& operator--(); //predec
+  string_iterator operator--(int); //postdec
+
+  //The key's shared prefix and suffix within its leaf, which together make up the key without copying it
+  std::string_view prefix() const;
+  std::string_view suffix() const;
+
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  string_iterator() : node(nullptr), pos(0) {}
+  string_iterator(const string_node *n, size_t pos)
+    : node(n), pos(pos) {}
+
+private:
+  //Store a current leaf as well as a slot within it
+  const string_node *node;
+  size_t pos;
+};
+
+static_assert(std::is_trivially_copyable<string_iterator>::value, "string_iterator must be trivially copyable");
+
+#include "string_iterator.tem"
+
+#endif
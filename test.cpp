@@ -5,16 +5,116 @@
 */
 
 #include "btree.h"
+#include "bplus_tree.h"
+#include "btree_map.h"
+#include "string_btree.h"
+#include "mapped_btree.h"
+#include "concurrent_btree.h"
+#include "versioned_btree.h"
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <cassert>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <fstream>
+#include <set>
+#include <map>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <cstdio>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <atomic>
+#include <climits>
+#include <thread>
 
 using namespace std;
 
+namespace {
+
+/**
+ * A memory resource which counts the bytes and allocations it hands out,
+ * so tests can check where a btree's memory comes from and that it is all returned.
+ **/
+class counting_resource : public std::pmr::memory_resource {
+ public:
+  size_t bytes = 0;
+  size_t allocations = 0;
+
+ private:
+  void* do_allocate(size_t n, size_t align) override {
+    bytes += n;
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(n, align);
+  }
+
+  void do_deallocate(void *p, size_t n, size_t align) override {
+    bytes -= n;
+    std::pmr::new_delete_resource()->deallocate(p, n, align);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * A record ordered by its id alone. The transparent comparator lets a btree of records
+ * be searched by an id, which cannot be converted into a record.
+ **/
+struct record {
+  int id;
+  std::string name;
+};
+
+struct record_by_id {
+  using is_transparent = void;
+
+  bool operator()(const record& a, const record& b) const { return a.id < b.id; }
+  bool operator()(const record& a, int id) const { return a.id < id; }
+  bool operator()(int id, const record& b) const { return id < b.id; }
+};
+
+/**
+ * A value which can only be moved and has no zero-arg constructor,
+ * holding its key behind a pointer so a moved-from value is easy to spot.
+ **/
+struct move_only_value {
+  explicit move_only_value(int key) : key(new int(key)) {}
+
+  bool operator<(const move_only_value& other) const { return *key < *other.key; }
+
+  std::unique_ptr<int> key;
+};
+
+/**
+ * An int which counts how many objects of its type are alive, so tests can
+ * tell how many element slots the nodes of a tree hold at any moment.
+ **/
+struct counted_int {
+  counted_int(int value = 0) : value(value) { ++live; }
+  counted_int(const counted_int& other) : value(other.value) { ++live; }
+  counted_int& operator=(const counted_int&) = default;
+  ~counted_int() { --live; }
+
+  bool operator<(const counted_int& other) const { return value < other.value; }
+
+  int value;
+  static inline long live = 0;
+};
+
+}  // namespace close
+
 //Main
 int main() {
 
@@ -104,7 +204,7 @@ int main() {
   }
 
   /*
-  * Test 4 - Create tree of size 1, should behave like a regular binary tree
+  * Test 4 - Create tree of size 1, which is rounded up to 2 elements per node and behaves like a 2-3 tree
   * Testing: Valid insertion, Size 1 BTree, Iteration over this tree, Test output of BTree using operator<<
   *
   */
@@ -115,10 +215,8 @@ int main() {
       btree<double> a(1); //binary tree
 
       /*
-      * Tree:                  10.5
-      *                      3.6    11.2
-      *                   -20            13.6
-      *                               12.5   100
+      * Tree:                  10.5       13.6
+      *                  -20 3.6    11.2 12.5    100
       */
       a.insert(10.5);
       a.insert(3.6);
@@ -133,7 +231,7 @@ int main() {
       ss << a;
       
       //If this fails, perhaps you have a final space after last element!
-      assert(ss.str() == "10.5 3.6 11.2 -20 13.6 12.5 100");
+      assert(ss.str() == "10.5 13.6 -20 3.6 11.2 12.5 100");
 
       //Now lets test iteration!
       vector<double> sol = { -20, 3.6, 10.5, 11.2, 12.5, 13.6, 100 };
@@ -175,7 +273,7 @@ int main() {
 
 
   /*
-  * Test 5 - Extending on from test 4, this is the main test. We will use a 3 level deep tree of ints with a size of 4 elements per node, duplicates also tested in addition to finding elements in tree
+  * Test 5 - Extending on from test 4, this is the main test. We will use a 2 level deep tree of ints with a size of 4 elements per node, duplicates also tested in addition to finding elements in tree
   * Testing: Valid insertion, Iteration over this tree, Test output of BTree using operator<<, duplicates, finding, copy constructors, move constructors, iterator const correctness
   *
   */
@@ -186,12 +284,8 @@ int main() {
       btree<int> a(4); //btree of size 4
 
       /*
-      * Tree:                  1    20   37                  105
-      *                      0   12            72 80 95 100     200 201 202          250
-      *                                    50                                 210 217      251
-      *                                  
-      *                                     
-      *                              
+      * Tree:                       20           80            105                 202
+      *                      0 1 12     37 50 72     95 100     200 201     210 217 250 251
       */
       a.insert(1);
       a.insert(105);
@@ -213,15 +307,17 @@ int main() {
 
       a.insert(251);
 
+      //Test that ret1-ret4 return correct pairs iterator and status is true (as they've been inserted)
+      //Inserting shifts values within a node, so each returned iterator is checked before the next insert
       auto ret1 = a.insert(95);
+      assert(ret1.second == true && *ret1.first == 95);
       auto ret2 = a.insert(72);
+      assert(ret2.second == true && *ret2.first == 72);
       auto ret3 =  a.insert(80);
+      assert(ret3.second == true && *ret3.first == 80);
 
       auto ret4 = a.insert(50);
-
-      //Test that ret1-ret4 return correct pairs iterator and status is true (as they've been inserted)
-	  assert((ret1.second == true) && (ret2.second == true) && (ret3.second == true) && (ret4.second == true));
-      assert(*ret1.first == 95 && *ret2.first == 72 && *ret3.first == 80 && *ret4.first == 50);
+      assert(ret4.second == true && *ret4.first == 50);
 
       //Test duplicate insertions
       auto ret5 = a.insert(200);
@@ -240,18 +336,18 @@ int main() {
       ss << a;
 
       //If this fails, perhaps you have a final space after last element!
-      assert(ss.str() == "1 20 37 105 0 12 72 80 95 100 200 201 202 250 50 210 217 251");
+      assert(ss.str() == "20 80 105 202 0 1 12 37 50 72 95 100 200 201 210 217 250 251");
 
       //Test same thing using copy constructor/move constructor
       btree<int> b = a; //copy
       stringstream ss2;
       ss2 << b;
-      assert(ss2.str() == "1 20 37 105 0 12 72 80 95 100 200 201 202 250 50 210 217 251");
+      assert(ss2.str() == "20 80 105 202 0 1 12 37 50 72 95 100 200 201 210 217 250 251");
 
       btree<int> c = std::move(b); //move (from b, leaving b in valid state)
       stringstream ss3;
       ss3 << c;
-      assert(ss3.str() == "1 20 37 105 0 12 72 80 95 100 200 201 202 250 50 210 217 251");
+      assert(ss3.str() == "20 80 105 202 0 1 12 37 50 72 95 100 200 201 210 217 250 251");
       
 
       //Now test this using operator =
@@ -259,12 +355,12 @@ int main() {
       d = a;
       stringstream ss4;
       ss4 << d;
-      assert(ss4.str() == "1 20 37 105 0 12 72 80 95 100 200 201 202 250 50 210 217 251");
+      assert(ss4.str() == "20 80 105 202 0 1 12 37 50 72 95 100 200 201 210 217 250 251");
 
       e = std::move(d);
       stringstream ss5;
       ss5 << e;
-      assert(ss5.str() == "1 20 37 105 0 12 72 80 95 100 200 201 202 250 50 210 217 251");
+      assert(ss5.str() == "20 80 105 202 0 1 12 37 50 72 95 100 200 201 210 217 250 251");
 
 
       //Now lets test iteration on tree A
@@ -350,11 +446,8 @@ int main() {
       btree<string> a(3); //string tree with size 3
 
       /*
-      * Tree:                   baby      hey       zed
-      *             aaaFirst ant     cat        tool    zzzLast
-      *
-      *
-      *
+      * Tree:                   baby      hey
+      *             aaaFirst ant     cat      tool zed zzzLast
       */
       a.insert("baby");
       a.insert("zed");
@@ -381,7 +474,7 @@ int main() {
       ss << a;
 
       //If this fails, perhaps you have a final space after last element!
-      assert(ss.str() == "baby hey zed aaaFirst ant cat tool zzzLast");
+      assert(ss.str() == "baby hey aaaFirst ant cat tool zed zzzLast");
       
       //Now lets test iteration!
       vector<string> sol = { "aaaFirst", "ant", "baby", "cat", "hey", "tool", "zed", "zzzLast" };
@@ -420,6 +513,1738 @@ int main() {
       exit(1);
     }
   }
+  /*
+  * Test 7 - Sorted and reverse sorted insertion must keep the tree balanced
+  * Testing: Node splitting, root growth, height() stays within the B-Tree bound, iteration after splits
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      const int count = 10000;
+
+      for (size_t nodeSize : { 2, 3, 4, 40 }) {
+        //Every non-root node holds at least half of nodeSize elements, so has at least that many plus one children
+        size_t minChilds = nodeSize / 2 + 1;
+        size_t maxHeight = 1;
+        for (size_t capacity = 2; capacity <= count; capacity *= minChilds)
+          ++maxHeight;
+
+        btree<int> sorted(nodeSize), reversed(nodeSize);
+
+        for (int i = 0; i < count; ++i) {
+          sorted.insert(i);
+          reversed.insert(count - 1 - i);
+        }
+
+        assert(sorted.height() <= maxHeight);
+        assert(reversed.height() <= maxHeight);
+
+        //Both trees must still iterate in increasing order
+        int expected = 0;
+        for (auto it = sorted.begin(); it != sorted.end(); ++it, ++expected)
+          assert(*it == expected);
+        assert(expected == count);
+
+        expected = count - 1;
+        for (auto it = reversed.rbegin(); it != reversed.rend(); ++it, --expected)
+          assert(*it == expected);
+        assert(expected == -1);
+      }
+
+      //An empty tree has no levels
+      btree<int> empty;
+      assert(empty.height() == 0);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 8 - Erasing elements rebalances the tree
+  * Testing: erase by value, iterator and range, returned successor iterators, height() bound after removals, erasing down to an empty tree
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      const int count = 5000;
+
+      for (size_t nodeSize : { 2, 3, 4, 40 }) {
+        btree<int> a(nodeSize);
+        set<int> expected;
+
+        for (int i = 0; i < count; ++i) {
+          a.insert(i);
+          expected.insert(i);
+        }
+
+        //Remove every third value by key, checking the returned count
+        for (int i = 0; i < count; i += 3) {
+          assert(a.erase(i) == 1);
+          expected.erase(i);
+        }
+        assert(a.erase(0) == 0);
+        assert(a.erase(count) == 0);
+
+        //Remove values by iterator, the returned iterator must point to the successor
+        for (int i = 1; i < count; i += 7) {
+          auto it = a.find(i);
+          if (it == a.end())
+            continue;
+
+          auto next = a.erase(it);
+          auto expectedNext = expected.upper_bound(i);
+          expected.erase(i);
+
+          if (expectedNext == expected.end())
+            assert(next == a.end());
+          else
+            assert(*next == *expectedNext);
+        }
+
+        //Remove a range from the middle
+        auto first = a.find(2000), last = a.find(3002);
+        auto next = a.erase(first, last);
+        assert(*next == 3002);
+        expected.erase(expected.find(2000), expected.find(3002));
+
+        //Contents and order must match
+        assert(std::equal(a.begin(), a.end(), expected.begin()));
+        assert(std::equal(a.rbegin(), a.rend(), expected.rbegin()));
+
+        //Height must stay within the B-Tree bound for the remaining elements
+        size_t minChilds = nodeSize / 2 + 1;
+        size_t maxHeight = 1;
+        for (size_t capacity = 2; capacity <= expected.size(); capacity *= minChilds)
+          ++maxHeight;
+        assert(a.height() <= maxHeight);
+
+        //Erase everything that remains, finishing at the end
+        auto emptied = a.erase(a.begin(), a.end());
+        assert(emptied == a.end() && a.begin() == a.end());
+        assert(a.height() == 0);
+
+        //Erasing the last element returns end()
+        a.insert(1);
+        a.insert(2);
+        auto afterLast = a.erase(a.find(2));
+        assert(afterLast == a.end());
+        assert(*a.begin() == 1);
+      }
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 9 - Bulk loading from sorted and unsorted ranges
+  * Testing: range constructor, assign_sorted() with fill factors, duplicates skipped, unsorted fallback, modifying a bulk loaded tree
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      for (size_t nodeSize : { 2, 3, 4, 40 }) {
+        for (int count : { 0, 1, 2, 5, 41, 1000 }) {
+          vector<int> values;
+          for (int i = 0; i < count; ++i)
+            values.push_back(i * 2);
+
+          //Packed load through the constructor
+          btree<int> a(values.begin(), values.end(), nodeSize);
+          assert(std::equal(values.begin(), values.end(), a.begin()));
+          assert(std::distance(a.begin(), a.end()) == count);
+
+          //Half full load must still stay within the B-Tree height bound
+          size_t minChilds = nodeSize / 2 + 1;
+          size_t maxHeight = 1;
+          for (size_t capacity = 2; capacity <= values.size(); capacity *= minChilds)
+            ++maxHeight;
+
+          btree<int> b(nodeSize);
+          b.insert(-1);
+          b.assign_sorted(values.begin(), values.end(), 0.5);
+          assert(std::equal(values.rbegin(), values.rend(), b.rbegin()));
+          assert(std::distance(b.begin(), b.end()) == count);
+          assert(a.height() <= b.height() && b.height() <= maxHeight);
+
+          //Both trees must keep working after a bulk load
+          set<int> expected(values.begin(), values.end());
+          for (int i = 0; i < count * 2; i += 3) {
+            a.insert(i);
+            b.erase(i);
+            expected.insert(i);
+          }
+          assert(std::equal(expected.begin(), expected.end(), a.begin()));
+          for (int i = 0; i < count * 2; i += 3)
+            assert(b.find(i) == b.end());
+        }
+      }
+
+      //Duplicates are skipped and unsorted input falls back to insertion
+      vector<string> words = { "ant", "bee", "bee", "cat", "dog", "aardvark", "eel", "cat" };
+      btree<string> c(words.begin(), words.end(), 2);
+      vector<string> sol = { "aardvark", "ant", "bee", "cat", "dog", "eel" };
+      assert(std::equal(sol.begin(), sol.end(), c.begin()));
+      assert(std::distance(c.begin(), c.end()) == 6);
+
+      //Clearing leaves an empty tree
+      c.clear();
+      assert(c.begin() == c.end() && c.height() == 0);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 10 - Custom comparators and allocators
+  * Testing: Compare template parameter, nodes drawn from a std::pmr memory resource in slabs, copy and move between pools, all memory returned on destruction
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      typedef btree<int, std::greater<int>, std::pmr::polymorphic_allocator<int>> pmr_btree;
+
+      counting_resource resource;
+
+      {
+        pmr_btree a(4, std::greater<int>(), &resource);
+
+        for (int i = 0; i < 1000; ++i)
+          a.insert(i);
+
+        for (int i = 0; i < 1000; i += 2)
+          a.erase(i);
+
+        //Greatest first ordering
+        int expected = 999;
+        for (auto it = a.begin(); it != a.end(); ++it, expected -= 2)
+          assert(*it == expected);
+        assert(expected == -1);
+
+        //Nodes are carved from a few slabs rather than allocated one by one
+        assert(resource.bytes > 0);
+        assert(resource.allocations < 20);
+        assert(a.get_allocator().resource() == &resource);
+
+        //A copy uses the allocator selected for container copies, and a moved tree keeps its pool
+        pmr_btree b = a;
+        assert(std::equal(a.begin(), a.end(), b.begin()));
+
+        pmr_btree c = std::move(a);
+        assert(c.get_allocator().resource() == &resource);
+        assert(std::equal(b.begin(), b.end(), c.begin()));
+
+        //The moved from tree is empty and usable
+        assert(a.begin() == a.end());
+        a.insert(5);
+        assert(*a.begin() == 5);
+
+        a = std::move(c);
+        assert(std::equal(b.begin(), b.end(), a.begin()));
+        assert(c.begin() == c.end());
+      }
+
+      //Every slab is returned once the trees are destroyed
+      assert(resource.bytes == 0);
+
+      //Strings need destructing, but their nodes are still returned in slabs
+      {
+        btree<string, std::less<string>, std::pmr::polymorphic_allocator<string>> words(3, std::less<string>(), &resource);
+
+        for (int i = 0; i < 500; ++i)
+          words.insert(std::to_string(i) + " is a string too long for the small string buffer");
+      }
+      assert(resource.bytes == 0);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 11 - Bounds and range scans
+  * Testing: lower_bound, upper_bound, equal_range and range agree with std::set, on const and non-const trees and across node sizes
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      for (size_t nodeSize = 2; nodeSize <= 9; nodeSize += 7) {
+        btree<int> a(nodeSize);
+        set<int> expected;
+
+        //Only even values are stored, so odd probes fall between elements
+        for (int i = 0; i < 500; ++i) {
+          int value = (i * 37 % 500) * 2;
+          a.insert(value);
+          expected.insert(value);
+        }
+
+        const btree<int>& constA = a;
+
+        for (int probe = -3; probe <= 1003; ++probe) {
+          auto lower = a.lower_bound(probe);
+          auto upper = constA.upper_bound(probe);
+          auto expectedLower = expected.lower_bound(probe);
+          auto expectedUpper = expected.upper_bound(probe);
+
+          assert((lower == a.end()) == (expectedLower == expected.end()));
+          assert(lower == a.end() || *lower == *expectedLower);
+          assert((upper == constA.end()) == (expectedUpper == expected.end()));
+          assert(upper == constA.end() || *upper == *expectedUpper);
+
+          auto equal = a.equal_range(probe);
+          assert(equal.first == lower);
+          assert(std::distance(equal.first, equal.second) == (ptrdiff_t) expected.count(probe));
+        }
+
+        //Scan every element in [100, 200)
+        vector<int> scanned;
+        for (int value : a.range(100, 200))
+          scanned.push_back(value);
+        assert(std::equal(scanned.begin(), scanned.end(), expected.lower_bound(100), expected.lower_bound(200)));
+        assert(scanned.size() == 50);
+
+        //Degenerate ranges are empty
+        assert(constA.range(201, 201).empty());
+        assert(constA.range(300, 100).empty());
+        assert(a.range(2000, 3000).empty());
+      }
+
+      //Empty tree
+      btree<int> empty;
+      assert(empty.lower_bound(1) == empty.end());
+      assert(empty.upper_bound(1) == empty.end());
+      assert(empty.range(0, 10).empty());
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 12 - Postfix iterator operations
+  * Testing: postfix ++ and -- return the previous position by value, iterators are trivially copyable
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      static_assert(std::is_trivially_copyable<btree<int>::iterator>::value, "iterator is not trivially copyable");
+      static_assert(std::is_trivially_copyable<btree<int>::const_iterator>::value, "const_iterator is not trivially copyable");
+
+      btree<int> a(3);
+      for (int i = 1; i <= 100; ++i)
+        a.insert(i);
+
+      //Walk forwards with postfix increment
+      int expected = 1;
+      for (auto it = a.begin(); it != a.end(); ) {
+        auto previous = it++;
+        assert(*previous == expected);
+        assert(it == a.end() || *it == expected + 1);
+        ++expected;
+      }
+      assert(expected == 101);
+
+      //And backwards with postfix decrement on a const tree
+      const btree<int>& constA = a;
+      btree<int>::const_iterator it = constA.end();
+      auto previous = it--;
+      assert(previous == constA.end());
+      assert(*it == 100);
+      while (it != constA.begin())
+        it--;
+      assert(*it == 1);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 13 - B+-tree variant
+  * Testing: bplus_tree insert, find, erase, bounds and scans in both directions agree with std::set, leaves stay linked through splits and merges
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      for (size_t nodeSize = 2; nodeSize <= 12; nodeSize += 5) {
+        bplus_tree<int> a(nodeSize);
+        set<int> expected;
+
+        for (int i = 0; i < 1000; ++i) {
+          int value = i * 263 % 1000;
+          auto result = a.insert(value);
+          assert(result.second && *result.first == value);
+          expected.insert(value);
+        }
+
+        //Duplicates are rejected
+        assert(!a.insert(500).second);
+
+        //Remove every third value, by value and through iterators
+        for (int i = 0; i < 1000; i += 3) {
+          if (i % 2 == 0) {
+            assert(a.erase(i) == 1);
+          }
+          else {
+            auto next = a.erase(a.find(i));
+            assert(next == a.end() || *next == *expected.upper_bound(i));
+          }
+          expected.erase(i);
+        }
+        assert(a.erase(0) == 0);
+
+        assert(std::equal(a.begin(), a.end(), expected.begin(), expected.end()));
+        assert(std::equal(a.rbegin(), a.rend(), expected.rbegin(), expected.rend()));
+
+        const bplus_tree<int>& constA = a;
+        assert(constA.find(1) != constA.end() && *constA.find(1) == 1);
+        assert(constA.find(3) == constA.end());
+        assert(*constA.lower_bound(3) == 4);
+        assert(*constA.upper_bound(4) == 5);
+
+        vector<int> scanned;
+        for (int value : a.range(100, 200))
+          scanned.push_back(value);
+        assert(std::equal(scanned.begin(), scanned.end(), expected.lower_bound(100), expected.lower_bound(200)));
+
+        //Copies are independent
+        bplus_tree<int> b = a;
+        b.insert(3);
+        assert(a.find(3) == a.end() && b.find(3) != b.end());
+
+        //Erasing everything shrinks the tree back to an empty leaf
+        for (auto it = a.begin(); it != a.end(); )
+          it = a.erase(it);
+        assert(a.begin() == a.end() && a.height() == 0);
+
+        a = std::move(b);
+        assert(a.find(3) != a.end());
+      }
+
+      //Printed in order, without separator keys
+      bplus_tree<string> words(2);
+      for (string word : {"pear", "apple", "fig", "kiwi", "lime"})
+        words.insert(word);
+
+      stringstream out;
+      out << words;
+      assert(out.str() == "apple fig kiwi lime pear");
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 14 - Node key search
+  * Testing: btree_lower_bound and btree_upper_bound match std::lower_bound and std::upper_bound for vectorised and generic key types across node sizes
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //Compare against the standard algorithms for every probe around a node of even keys
+      auto checkSearch = [](auto sample) {
+        typedef decltype(sample) Key;
+
+        for (size_t n = 0; n <= 300; n += (n < 20 ? 1 : 37)) {
+          vector<Key> keys;
+          for (size_t i = 0; i < n; ++i)
+            keys.push_back(static_cast<Key>(2 * i) - static_cast<Key>(n));
+
+          for (long probe = -static_cast<long>(n) - 2; probe <= static_cast<long>(n) + 2; ++probe) {
+            Key elem = static_cast<Key>(probe);
+            assert(btree_lower_bound(keys.data(), n, elem, std::less<Key>()) == size_t(std::lower_bound(keys.begin(), keys.end(), elem) - keys.begin()));
+            assert(btree_upper_bound(keys.data(), n, elem, std::less<Key>()) == size_t(std::upper_bound(keys.begin(), keys.end(), elem) - keys.begin()));
+          }
+        }
+      };
+
+      checkSearch(int());
+      checkSearch(long());
+      checkSearch((long long) 0);
+      checkSearch(float());
+      checkSearch(double());
+      checkSearch(short());
+
+      //Keys far apart in magnitude, where narrowing conversions would go wrong
+      vector<long> wide = {-4000000000000L, -3, 0, 5, 4000000000000L};
+      assert(btree_lower_bound(wide.data(), wide.size(), 4L, std::less<long>()) == 3);
+      assert(btree_upper_bound(wide.data(), wide.size(), 4000000000000L, std::less<long>()) == 5);
+
+      //Long keys are vectorised in every SIMD build, including plain SSE2 where they are compared a half at a time,
+      //so probe keys sharing a high half either side of the low half's sign bit, and the extremes
+      assert((btree_simd_search<long, std::less<long> >::value == bool(BTREE_SIMD_SEARCH)));
+      vector<long> halves = {LONG_MIN, LONG_MIN + 1, -0x100000000L, -0x80000001L, -0x80000000L, -0x7fffffffL, -1, 0,
+                             1, 0x7fffffffL, 0x80000000L, 0xffffffffL, 0x100000000L, 0x180000000L, LONG_MAX - 1, LONG_MAX};
+      for (long probe : halves) {
+        for (long elem : {probe - (probe != LONG_MIN), probe, probe + (probe != LONG_MAX)}) {
+          assert(btree_lower_bound(halves.data(), halves.size(), elem, std::less<long>()) == size_t(std::lower_bound(halves.begin(), halves.end(), elem) - halves.begin()));
+          assert(btree_upper_bound(halves.data(), halves.size(), elem, std::less<long>()) == size_t(std::upper_bound(halves.begin(), halves.end(), elem) - halves.begin()));
+        }
+      }
+
+      //Other orderings fall back to the comparator
+      vector<int> descending = {9, 7, 5, 3, 1};
+      assert(btree_lower_bound(descending.data(), descending.size(), 5, std::greater<int>()) == 2);
+      assert(btree_upper_bound(descending.data(), descending.size(), 5, std::greater<int>()) == 3);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 15 - Compile time fanout
+  * Testing: fixed_btree default capacity from sizeof(T), fixed capacities behave as the runtime equivalent, constructor capacity ignored when fixed
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //Eight cache lines of keys, but never fewer than four per node
+      static_assert(btree_default_fanout<long>::value == 64, "unexpected default fanout");
+      static_assert(btree_default_fanout<int>::value == 128, "unexpected default fanout");
+      static_assert(btree_default_fanout<char[200]>::value == 4, "unexpected default fanout");
+
+      //A fixed capacity of 3 splits exactly like a runtime capacity of 3, whatever is passed to the constructor
+      fixed_btree<int, 3> fixed(100);
+      btree<int> runtime(3);
+      set<int> expected;
+
+      for (int i = 0; i < 500; ++i) {
+        int value = i * 71 % 500;
+        fixed.insert(value);
+        runtime.insert(value);
+        expected.insert(value);
+      }
+
+      for (int i = 0; i < 500; i += 4) {
+        fixed.erase(i);
+        runtime.erase(i);
+        expected.erase(i);
+      }
+
+      stringstream fixedOut, runtimeOut;
+      fixedOut << fixed;
+      runtimeOut << runtime;
+      assert(fixedOut.str() == runtimeOut.str());
+      assert(fixed.height() == runtime.height());
+      assert(std::equal(fixed.begin(), fixed.end(), expected.begin(), expected.end()));
+
+      //Copies and moves keep the fixed capacity
+      fixed_btree<int, 3> copy = fixed;
+      fixed_btree<int, 3> moved = std::move(copy);
+      assert(std::equal(moved.begin(), moved.end(), expected.begin(), expected.end()));
+      copy = moved;
+      assert(copy.height() == fixed.height());
+
+      //Default capacity with vector searched keys
+      fixed_btree<long> wide;
+      for (long i = 0; i < 10000; ++i)
+        wide.insert(i * 7919 % 10000);
+      assert(wide.height() <= 3);
+      assert(*wide.lower_bound(5000) == 5000 && wide.find(10000) == wide.end());
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 16 - Heterogeneous lookup
+  * Testing: find, bounds, count and contains by types other than T with a transparent Compare
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //Strings looked up from literals and string_views
+      btree<string, std::less<> > words(3);
+      for (const char *word : {"comp1000", "comp2000", "comp3000", "comp6771", "comp9024", "comp9318"})
+        words.insert(word);
+
+      assert(words.find("comp6771") != words.end() && *words.find("comp6771") == "comp6771");
+      assert(words.find(string_view("comp4000")) == words.end());
+      assert(*words.lower_bound(string_view("comp4")) == "comp6771");
+      assert(*words.upper_bound("comp6771") == "comp9024");
+      assert(words.count("comp9318") == 1 && words.count("comp0000") == 0);
+      assert(words.contains(string_view("comp1000")) && !words.contains("comp1001"));
+
+      const btree<string, std::less<> >& constWords = words;
+      auto found = constWords.equal_range(string_view("comp3000"));
+      assert(std::distance(found.first, found.second) == 1 && *found.first == "comp3000");
+      found = constWords.equal_range("comp3001");
+      assert(found.first == found.second && *found.first == "comp6771");
+
+      //Records found by id alone, no record is ever built for the search
+      btree<record, record_by_id> records(4);
+      for (int i = 0; i < 200; ++i)
+        records.insert(record{i * 3, "record " + to_string(i)});
+
+      assert(records.find(150)->name == "record 50");
+      assert(records.find(151) == records.end());
+      assert(records.lower_bound(151)->id == 153);
+      assert(records.upper_bound(597) == records.end());
+      assert(records.contains(0) && !records.contains(-3) && records.count(597) == 1);
+
+      //Element typed lookups keep working alongside, and still use vector search for arithmetic keys
+      btree<int, std::less<> > numbers;
+      for (int i = 0; i < 1000; i += 2)
+        numbers.insert(i);
+      assert(numbers.contains(500) && !numbers.contains(501) && *numbers.lower_bound(501) == 502);
+      assert(*numbers.find(long(998)) == 998 && numbers.count(1000L) == 0);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 17 - Move aware and hinted insertion
+  * Testing: insert by rvalue, emplace, hinted insert with right and wrong hints, move only elements
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //Move only elements without a zero-arg constructor
+      btree<move_only_value> values(3);
+      for (int i = 0; i < 100; ++i) {
+        move_only_value value(i * 37 % 100);
+        assert(values.insert(std::move(value)).second && !value.key);
+      }
+
+      //A duplicate is left with its caller
+      move_only_value duplicate(50);
+      assert(!values.insert(std::move(duplicate)).second && duplicate.key && *duplicate.key == 50);
+
+      assert(*values.emplace(100).first->key == 100 && !values.emplace(7).second);
+      assert(*values.emplace_hint(values.end(), 101)->key == 101);
+
+      int expected = 0;
+      for (const move_only_value& value : values)
+        assert(*value.key == expected++);
+      assert(expected == 102);
+
+      //Appending increasing values at end()
+      btree<int> appended(4);
+      for (int i = 0; i < 1000; ++i)
+        assert(*appended.insert(appended.end(), i) == i);
+
+      assert(appended.height() > 1);
+      expected = 0;
+      for (int value : appended)
+        assert(value == expected++);
+
+      //Right, wrong and matching hints all agree with an ordinary insert
+      btree<int> hinted(3);
+      set<int> reference;
+      for (int i = 0; i < 500; ++i) {
+        int value = i * 131 % 457;
+        btree<int>::const_iterator hint;
+
+        switch (i % 4) {
+          case 0: hint = hinted.lower_bound(value); break;
+          case 1: hint = hinted.cbegin(); break;
+          case 2: hint = hinted.cend(); break;
+          default: hint = hinted.upper_bound(value); break;
+        }
+
+        btree<int>::iterator it = hinted.insert(hint, value);
+        assert(*it == value);
+        reference.insert(value);
+      }
+
+      assert(std::equal(hinted.begin(), hinted.end(), reference.begin(), reference.end()));
+      assert(std::equal(hinted.rbegin(), hinted.rend(), reference.rbegin(), reference.rend()));
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 18 - Maps, multimaps and multisets
+  * Testing: btree_map against std::map, operator[], at, try_emplace, insert_or_assign, multi variants against std::multimap and std::multiset
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      btree_map<int, string> map(3);
+      std::map<int, string> referenceMap;
+      std::mt19937 rng(18);
+
+      for (int i = 0; i < 3000; ++i) {
+        int key = rng() % 400;
+        string value = std::to_string(rng() % 1000);
+
+        switch (rng() % 5) {
+          case 0: assert(map.insert(make_pair(key, value)).second == referenceMap.insert(make_pair(key, value)).second); break;
+          case 1: map[key] = value; referenceMap[key] = value; break;
+          case 2: assert(map.insert_or_assign(key, value).second == referenceMap.insert_or_assign(key, value).second); break;
+          case 3: assert(map.try_emplace(key, value).second == referenceMap.try_emplace(key, value).second); break;
+          default: assert(map.erase(key) == referenceMap.erase(key)); break;
+        }
+      }
+
+      auto expected = referenceMap.begin();
+      for (auto [key, value] : map) {
+        assert(key == expected->first && value == expected->second);
+        ++expected;
+      }
+      assert(expected == referenceMap.end());
+
+      //Values are reached through the iterator and at, which throws for missing keys
+      int firstKey = referenceMap.begin()->first;
+      map.find(firstKey)->second = "changed";
+      assert(map.at(firstKey) == "changed");
+
+      bool threw = false;
+      try {
+        map.at(1000);
+      }
+      catch (std::out_of_range&) {
+        threw = true;
+      }
+      assert(threw && map.find(1000) == map.end());
+
+      //try_emplace leaves an existing value alone, insert_or_assign replaces it
+      assert(!map.try_emplace(firstKey, "ignored").second && map[firstKey] == "changed");
+      assert(!map.insert_or_assign(firstKey, "assigned").second && map[firstKey] == "assigned");
+      assert(map[1000].empty() && map.count(1000) == 1);
+
+      //Copies carry their values with them
+      const btree_map<int, string> copy(map);
+      assert(copy.at(firstKey) == "assigned" && std::distance(copy.begin(), copy.end()) == std::distance(map.begin(), map.end()));
+
+      //Move only mapped values
+      btree_map<int, std::unique_ptr<int>> owners(4);
+      for (int i = 0; i < 200; ++i)
+        owners.try_emplace(i * 7 % 200, new int(i));
+      for (const auto& [key, owner] : owners)
+        assert(*owner * 7 % 200 == key);
+
+      //Equivalent keys stay in insertion order, as in std::multimap
+      btree_multimap<int, int> multimap(3);
+      std::multimap<int, int> referenceMultimap;
+      for (int i = 0; i < 2000; ++i) {
+        int key = rng() % 50;
+
+        if (rng() % 4 == 0) {
+          assert(multimap.erase(key) == referenceMultimap.erase(key));
+        }
+        else {
+          multimap.insert(make_pair(key, i));
+          referenceMultimap.insert(make_pair(key, i));
+        }
+      }
+
+      auto expectedPair = referenceMultimap.begin();
+      for (auto [key, value] : multimap) {
+        assert(key == expectedPair->first && value == expectedPair->second);
+        ++expectedPair;
+      }
+      assert(expectedPair == referenceMultimap.end());
+
+      for (int key = 0; key < 50; ++key) {
+        auto range = multimap.equal_range(key);
+        assert(size_t(std::distance(range.first, range.second)) == referenceMultimap.count(key));
+        assert(multimap.count(key) == referenceMultimap.count(key));
+        if (range.first != range.second)
+          assert(multimap.find(key) == range.first && multimap.find(key)->second == referenceMultimap.find(key)->second);
+      }
+
+      btree_multiset<int> multiset(3);
+      std::multiset<int> referenceMultiset;
+      for (int i = 0; i < 2000; ++i) {
+        int value = rng() % 100;
+        assert(*multiset.insert(value) == value);
+        referenceMultiset.insert(value);
+      }
+      assert(multiset.erase(42) == referenceMultiset.erase(42));
+      assert(std::equal(multiset.begin(), multiset.end(), referenceMultiset.begin(), referenceMultiset.end()));
+      assert(multiset.count(7) == referenceMultiset.count(7));
+
+      //Sorted input with repeats bulk loads into a multiset
+      vector<int> sorted(referenceMultiset.begin(), referenceMultiset.end());
+      btree_multiset<int> loaded(sorted.begin(), sorted.end(), 5);
+      assert(std::equal(loaded.begin(), loaded.end(), sorted.begin(), sorted.end()));
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 19 - Prefix compressed string keys
+  * Testing: string_btree against std::set, string_view and literal lookups, erase, copies, output, memory compared with btree<string>
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //A dictionary of words sharing long prefixes, like a sorted word list
+      const char *stems[] = {"", "A", "AB", "ABAC", "ABACUS", "ZYZZYVA", "ZYZZ", "Z", "QUIXOTIC"};
+      vector<string> words;
+      for (const char *stem : stems)
+        for (int i = 0; i < 400; ++i)
+          words.push_back(stem + std::to_string(i * 7 % 400));
+
+      for (size_t maxNodeElems : {2, 3, 8, 40}) {
+        string_btree<> dictionary(maxNodeElems);
+        set<string> reference;
+
+        for (const string& word : words)
+          assert(dictionary.insert(word).second == reference.insert(word).second);
+
+        assert(std::equal(dictionary.begin(), dictionary.end(), reference.begin(), reference.end()));
+        assert(std::equal(dictionary.rbegin(), dictionary.rend(), reference.rbegin(), reference.rend()));
+
+        //Searches take views and literals, including probes sharing part of a node's prefix
+        assert(dictionary.contains("ZYZZYVA12") && *dictionary.find(std::string_view("ABACUS399")) == "ABACUS399");
+        assert(!dictionary.contains("ZYZZYV") && !dictionary.contains("ABACUS4000") && !dictionary.contains(""));
+        assert(*dictionary.lower_bound("ZYZZYV") == *reference.lower_bound("ZYZZYV"));
+        assert(*dictionary.upper_bound("ABACUS") == *reference.upper_bound("ABACUS"));
+        assert(dictionary.lower_bound("ZZ") == dictionary.end() && dictionary.find("ZZ") == dictionary.end());
+
+        //Remove every other word, some by iterator
+        size_t n = 0;
+        for (const string& word : words) {
+          if (n++ % 2)
+            continue;
+
+          if (n % 3) {
+            assert(dictionary.erase(word) == reference.erase(word));
+          }
+          else {
+            auto it = dictionary.find(word);
+            auto next = dictionary.erase(it);
+            auto expected = std::next(reference.find(word));
+            reference.erase(word);
+            assert(expected == reference.end() ? next == dictionary.end() : *next == *expected);
+          }
+        }
+
+        const string_btree<> copy(dictionary);
+        assert(std::equal(copy.begin(), copy.end(), reference.begin(), reference.end()));
+
+        std::ostringstream printed, expected;
+        printed << copy;
+        for (auto it = reference.begin(); it != reference.end(); ++it)
+          expected << (it == reference.begin() ? "" : " ") << *it;
+        assert(printed.str() == expected.str());
+      }
+
+      //Packed keys take a fraction of the memory of a node array of strings
+      counting_resource packedResource, stringResource;
+      {
+        std::sort(words.begin(), words.end());
+        string_btree<std::pmr::polymorphic_allocator<char>> packed(40, &packedResource);
+        btree<string, std::less<string>, std::pmr::polymorphic_allocator<string>> strings(40, std::less<string>(), &stringResource);
+
+        for (const string& word : words) {
+          packed.insert(word);
+          strings.insert(word);
+        }
+
+        assert(packedResource.bytes * 2 < stringResource.bytes);
+      }
+      assert(packedResource.bytes == 0);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 20 - Memory mapped pages
+  * Testing: mapped_btree written from btrees of several page sizes, iteration, find and bounds against std::set, empty files, rejected files, move
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      const string path = "test_mapped.btree";
+
+      std::mt19937 gen(20);
+      std::uniform_int_distribution<int> dist(-50000, 50000);
+      btree<int> tree(40);
+      set<int> reference;
+
+      for (int i = 0; i < 20000; ++i) {
+        int value = dist(gen);
+        tree.insert(value);
+        reference.insert(value);
+      }
+
+      //Small pages give a tall tree of many internal levels, the header page being the smallest a page can be
+      for (size_t pageSize : {72, 128, 256, 4096}) {
+        mapped_btree<int>::write(tree, path, pageSize);
+        mapped_btree<int> mapped(path);
+
+        assert(mapped.size() == reference.size() && !mapped.empty());
+        assert(pageSize > 128 || mapped.height() > 3);
+        assert(std::equal(mapped.begin(), mapped.end(), reference.begin(), reference.end()));
+        assert(std::equal(mapped.rbegin(), mapped.rend(), reference.rbegin(), reference.rend()));
+
+        for (int probe = -50010; probe <= 50010; probe += 7) {
+          assert(mapped.contains(probe) == (reference.count(probe) == 1));
+          assert(std::distance(mapped.begin(), mapped.lower_bound(probe)) == std::distance(reference.begin(), reference.lower_bound(probe)));
+          assert(std::distance(mapped.begin(), mapped.upper_bound(probe)) == std::distance(reference.begin(), reference.upper_bound(probe)));
+
+          auto range = mapped.equal_range(probe);
+          assert(std::distance(range.first, range.second) == (long)reference.count(probe));
+        }
+
+        assert(*mapped.find(*reference.begin()) == *reference.begin() && mapped.find(*reference.rbegin()) == --mapped.end());
+      }
+
+      //Any container iterated in order can be written, and the file moves with its owner
+      set<double> doubles = {-1.5, 0.0, 0.25, 2.0, 1e10};
+      mapped_btree<double>::write(doubles, path);
+      mapped_btree<double> first(path);
+      mapped_btree<double> second(std::move(first));
+      assert(first.empty() && first.begin() == first.end() && first.find(0.25) == first.end());
+      assert(std::equal(second.begin(), second.end(), doubles.begin(), doubles.end()) && second.height() == 1);
+      first = std::move(second);
+      assert(*first.find(0.25) == 0.25 && first.lower_bound(3.0) == --first.end() && first.upper_bound(1e10) == first.end());
+
+      //An empty tree has no leaves at all
+      mapped_btree<int>::write(btree<int>(), path);
+      mapped_btree<int> none(path);
+      assert(none.empty() && none.height() == 0 && none.begin() == none.end() && none.rbegin() == none.rend());
+      assert(none.find(1) == none.end() && none.lower_bound(1) == none.end());
+
+      //Headers whose first leaf lies past the file or after the last leaf are refused
+      auto refusesFirstLeaf = [&](uint64_t firstLeaf) {
+        mapped_btree<int>::write(tree, path, 256);
+        {
+          std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+          file.seekp(offsetof(btree_file_header, firstLeaf));
+          file.write(reinterpret_cast<const char*>(&firstLeaf), sizeof(firstLeaf));
+        }
+
+        try {
+          mapped_btree<int> corrupt(path);
+        }
+        catch (const std::runtime_error&) {
+          return true;
+        }
+        return false;
+      };
+
+      btree_file_header header;
+      mapped_btree<int>::write(tree, path, 256);
+      std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header));
+      assert(header.lastLeaf + 1 < header.pages && !refusesFirstLeaf(header.firstLeaf));
+      assert(refusesFirstLeaf(header.pages) && refusesFirstLeaf(~uint64_t(0)) && refusesFirstLeaf(header.lastLeaf + 1));
+
+      //Files of another element type, or that are missing, are refused
+      bool threw = false;
+      try {
+        mapped_btree<long> wrong(path);
+      }
+      catch (const std::runtime_error&) {
+        threw = true;
+      }
+      assert(threw);
+
+      std::remove(path.c_str());
+      threw = false;
+      try {
+        mapped_btree<int> missing(path);
+      }
+      catch (const std::system_error&) {
+        threw = true;
+      }
+      assert(threw);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 21 - Binary save and load
+  * Testing: save and load of sets, string elements, maps and multisets, node size, empty trees, corrupt, truncated and mistyped streams
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //Enough elements for many stream blocks
+      btree<int> numbers(8);
+      for (int i = 0; i < 100000; ++i)
+        numbers.insert(i * 7919 % 100003);
+
+      std::stringstream saved(std::ios::in | std::ios::out | std::ios::binary);
+      numbers.save(saved);
+
+      btree<int> loaded(40);
+      loaded.insert(-1);
+      loaded.load(saved);
+      assert(std::equal(loaded.begin(), loaded.end(), numbers.begin(), numbers.end()) && loaded.count(-1) == 0);
+
+      //Loading adopts the saved node size, packing nodes as a bulk load does
+      btree<int> packed(numbers.begin(), numbers.end(), 8);
+      btree<int> packedWide(numbers.begin(), numbers.end(), 40);
+      assert(loaded.height() == packed.height() && packed.height() > packedWide.height());
+
+      loaded.insert(200000);
+      assert(*--loaded.end() == 200000);
+
+      //Strings are length prefixed, and maps save each key with its mapped value
+      btree<string> words;
+      for (const char *word : {"", "pear", "apple", "a much longer string than the small string buffer holds"})
+        words.insert(word);
+
+      btree_map<int, string> names;
+      btree_multiset<double> repeats;
+      for (int i = 0; i < 1000; ++i) {
+        names[i * 3] = std::to_string(i);
+        repeats.insert(i % 10 * 0.5);
+      }
+
+      std::stringstream wordStream, nameStream, repeatStream;
+      words.save(wordStream);
+      names.save(nameStream);
+      repeats.save(repeatStream);
+
+      btree<string> wordCopy;
+      btree_map<int, string> nameCopy;
+      btree_multiset<double> repeatCopy;
+      wordCopy.load(wordStream);
+      nameCopy.load(nameStream);
+      repeatCopy.load(repeatStream);
+
+      assert(std::equal(wordCopy.begin(), wordCopy.end(), words.begin(), words.end()));
+      assert(std::distance(nameCopy.begin(), nameCopy.end()) == 1000 && nameCopy.at(2997) == "999" && nameCopy.count(1) == 0);
+      assert(std::equal(repeatCopy.begin(), repeatCopy.end(), repeats.begin(), repeats.end()) && repeatCopy.count(4.5) == 100);
+
+      //An empty tree round trips to an empty tree
+      std::stringstream emptyStream;
+      btree<int>().save(emptyStream);
+      loaded.load(emptyStream);
+      assert(loaded.begin() == loaded.end() && loaded.height() == 0);
+
+      //Streams which fail their checks leave the tree as it was
+      auto rejects = [](const string& bytes) {
+        btree<int> target;
+        target.insert(42);
+        std::istringstream in(bytes);
+
+        try {
+          target.load(in);
+        }
+        catch (const std::runtime_error&) {
+          return std::distance(target.begin(), target.end()) == 1 && *target.begin() == 42;
+        }
+        return false;
+      };
+
+      string bytes = saved.str();
+      string flipped = bytes;
+      flipped[bytes.size() / 2] ^= 0x10;
+      assert(rejects(flipped));
+      assert(rejects(bytes.substr(0, bytes.size() - 1)));
+      assert(rejects(bytes.substr(0, bytes.size() / 3)));
+      assert(rejects(nameStream.str()));
+      assert(rejects("not a btree at all, just some text long enough for a header"));
+
+      //A corrupt node size is rejected before any node is built
+      string oversized = bytes;
+      uint64_t hugeNodes = std::numeric_limits<uint64_t>::max() / 2;
+      std::memcpy(&oversized[offsetof(btree_stream_header, maxNodeElems)], &hugeNodes, sizeof(hugeNodes));
+      assert(rejects(oversized));
+
+      //Block lengths are not trusted either: a block claiming nearly 4GB is refused once the stream runs out,
+      //and one claiming more elements than bytes is refused outright
+      auto withBlock = [&](uint32_t elements, uint32_t length) {
+        uint32_t counts[2] = {elements, length};
+        return bytes.substr(0, sizeof(btree_stream_header)) + string(reinterpret_cast<const char*>(counts), sizeof(counts)) + string(64, 'x');
+      };
+      assert(rejects(withBlock(1, 0xfffffff0u)) && rejects(withBlock(16, 8)));
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 22 - Concurrent access
+  * Testing: concurrent_btree against std::set from one thread, then inserts, removals, searches and scans from several threads at once
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      //Small nodes split and grow the tree often
+      {
+        concurrent_btree<int, std::less<int>, std::allocator<int>, 4> tree;
+        set<int> reference;
+        std::mt19937 gen(22);
+        std::uniform_int_distribution<int> dist(0, 3000);
+
+        for (int i = 0; i < 30000; ++i) {
+          int value = dist(gen);
+
+          if (i % 3 == 2)
+            assert(tree.erase(value) == (reference.erase(value) == 1));
+          else
+            assert(tree.insert(value) == reference.insert(value).second);
+
+          int probe = dist(gen);
+          assert(tree.contains(probe) == (reference.count(probe) == 1));
+        }
+
+        for (int probe = -1; probe <= 3001; ++probe)
+          assert(tree.contains(probe) == (reference.count(probe) == 1));
+
+        vector<int> all;
+        tree.scan(INT_MIN, reference.size() + 10, std::back_inserter(all));
+        assert(std::equal(all.begin(), all.end(), reference.begin(), reference.end()));
+
+        vector<int> some;
+        tree.scan(1500, 25, std::back_inserter(some));
+        assert(std::equal(some.begin(), some.end(), reference.lower_bound(1500)) && some.size() == 25);
+      }
+
+      //Writers insert interleaved ranges while readers search and scan, then half of everything is removed
+      {
+        const int threads = 4, perThread = 20000;
+        concurrent_btree<long, std::less<long>, std::allocator<long>, 8> tree;
+        std::atomic<bool> writing(true);
+        std::atomic<bool> ordered(true);
+
+        vector<std::thread> readers;
+        for (int r = 0; r < 2; ++r) {
+          readers.emplace_back([&tree, &writing, &ordered, r] {
+            std::mt19937 gen(r);
+            while (writing.load()) {
+              tree.contains(gen() % (threads * perThread));
+
+              vector<long> window;
+              tree.scan(gen() % (threads * perThread), 100, std::back_inserter(window));
+              if (!std::is_sorted(window.begin(), window.end()) || std::adjacent_find(window.begin(), window.end()) != window.end())
+                ordered = false;
+            }
+          });
+        }
+
+        vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+          writers.emplace_back([&tree, t] {
+            for (long i = 0; i < perThread; ++i)
+              tree.insert(i * threads + t);
+          });
+        }
+
+        for (std::thread& writer : writers)
+          writer.join();
+
+        writers.clear();
+        for (int t = 0; t < threads; ++t) {
+          writers.emplace_back([&tree, t] {
+            for (long i = t; i < threads * perThread; i += 2 * threads)
+              assert(tree.erase(i) && !tree.erase(i));
+          });
+        }
+
+        for (std::thread& writer : writers)
+          writer.join();
+
+        writing = false;
+        for (std::thread& reader : readers)
+          reader.join();
+
+        assert(ordered);
+
+        vector<long> all;
+        tree.scan(0, threads * perThread, std::back_inserter(all));
+        assert(all.size() == size_t(threads * perThread / 2));
+        for (size_t i = 0; i < all.size(); ++i)
+          assert(all[i] == long(i / threads * 2 * threads + threads + i % threads));
+      }
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 23 - Versioned snapshots
+  * Testing: versioned_btree against std::set, snapshots staying unchanged under later writes, reclamation of replaced nodes, snapshots taken while another thread writes
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      counting_resource resource;
+      {
+        versioned_btree<int, std::less<int>, std::pmr::polymorphic_allocator<int>, 4> tree(std::less<int>(), &resource);
+        set<int> reference;
+        vector<pair<versioned_btree<int, std::less<int>, std::pmr::polymorphic_allocator<int>, 4>::snapshot_type, set<int> > > kept;
+        std::mt19937 gen(23);
+        std::uniform_int_distribution<int> dist(0, 2000);
+
+        for (int i = 0; i < 20000; ++i) {
+          int value = dist(gen);
+
+          if (i % 5 < 2)
+            assert(tree.erase(value) == (reference.erase(value) == 1));
+          else
+            assert(tree.insert(value) == reference.insert(value).second);
+
+          if (i % 2000 == 0)
+            kept.emplace_back(tree.snapshot(), reference);
+        }
+
+        assert(tree.size() == reference.size());
+
+        //Every snapshot still shows the tree as it was when taken
+        for (const auto& entry : kept) {
+          const auto& snapshot = entry.first;
+          const set<int>& then = entry.second;
+
+          assert(snapshot.size() == then.size());
+          assert(std::equal(snapshot.begin(), snapshot.end(), then.begin(), then.end()));
+          assert(std::equal(snapshot.rbegin(), snapshot.rend(), then.rbegin(), then.rend()));
+
+          for (int probe = -1; probe <= 2001; probe += 3) {
+            assert(snapshot.contains(probe) == (then.count(probe) == 1));
+            assert((snapshot.find(probe) != snapshot.end()) == (then.count(probe) == 1));
+            assert(std::distance(snapshot.begin(), snapshot.lower_bound(probe)) == std::distance(then.begin(), then.lower_bound(probe)));
+            assert(std::distance(snapshot.begin(), snapshot.upper_bound(probe)) == std::distance(then.begin(), then.upper_bound(probe)));
+          }
+        }
+
+        auto full = tree.snapshot();
+        for (int value : reference)
+          tree.erase(value);
+        auto none = tree.snapshot();
+        assert(none.empty() && none.begin() == none.end() && none.find(1) == none.end() && !none.contains(1));
+        assert(full.size() == reference.size() && std::equal(full.begin(), full.end(), reference.begin(), reference.end()));
+
+        //A moved-from snapshot is empty and no longer reads the version it gave up
+        auto taken(std::move(full));
+        assert(full.empty() && full.begin() == full.end() && full.rbegin() == full.rend());
+        assert(full.find(1) == full.end() && full.lower_bound(1) == full.end() && full.upper_bound(1) == full.end() && !full.contains(1));
+        assert(std::equal(taken.begin(), taken.end(), reference.begin(), reference.end()));
+
+        taken = std::move(none);
+        assert(taken.empty() && taken.begin() == taken.end() && none.size() == reference.size());
+      }
+      assert(resource.bytes == 0);
+
+      //Replaced nodes are kept while a snapshot can reach them, and freed by the next write once none can
+      {
+        versioned_btree<counted_int, std::less<counted_int>, std::allocator<counted_int>, 4> tree;
+        for (int i = 0; i < 1000; ++i)
+          tree.insert(i);
+
+        long settled = counted_int::live;
+        {
+          auto pinned = tree.snapshot();
+          for (int i = 0; i < 1000; ++i)
+            tree.insert(i + 1000);
+
+          long held = counted_int::live;
+          for (int i = 0; i < 1000; ++i)
+            tree.erase(i + 1000);
+
+          assert(counted_int::live > held && pinned.size() == 1000);
+        }
+
+        tree.insert(5000);
+        assert(counted_int::live <= settled + 4 * 4);
+      }
+      assert(counted_int::live == 0);
+
+      //Readers take snapshots and check each is a consistent, complete version while a writer inserts and removes
+      {
+        versioned_btree<string> tree;
+        std::atomic<bool> writing(true);
+        std::atomic<bool> consistent(true);
+
+        vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r) {
+          readers.emplace_back([&tree, &writing, &consistent] {
+            while (writing.load()) {
+              auto snapshot = tree.snapshot();
+              size_t n = std::distance(snapshot.begin(), snapshot.end());
+
+              //Each a is inserted before its b and removed after it, so no version holds a b without its a
+              size_t unpaired = 0;
+              for (const string& value : snapshot)
+                unpaired += value.back() == 'b' && !snapshot.contains(value.substr(0, value.size() - 1) + "a");
+
+              if (n != snapshot.size() || unpaired != 0 || !std::is_sorted(snapshot.begin(), snapshot.end()))
+                consistent = false;
+            }
+          });
+        }
+
+        std::thread writerThread([&tree, &writing] {
+          for (int i = 0; i < 3000; ++i) {
+            string key = "key" + std::to_string(i % 500);
+
+            if (i % 1000 < 500) {
+              tree.insert(key + "a");
+              tree.insert(key + "b");
+            }
+            else {
+              tree.erase(key + "b");
+              tree.erase(key + "a");
+            }
+          }
+          writing = false;
+        });
+
+        writerThread.join();
+        for (std::thread& reader : readers)
+          reader.join();
+
+        assert(consistent);
+      }
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 24 - Parallel build and scan
+  * Testing: assign_parallel against std::set, std::multiset and std::map built from the same input, the first of equivalent elements being kept, split covering every element once in order, parallel_for_each visiting every element once
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      std::mt19937 gen(24);
+      vector<int> input(20000);
+      for (int& value : input)
+        value = static_cast<int>(gen() % 15000);
+
+      for (size_t nodeSize : {2, 3, 4, 7, 40}) {
+        for (size_t threads : {1, 3, 8}) {
+          set<int> reference(input.begin(), input.end());
+
+          btree<int> tree(nodeSize);
+          tree.insert(-1);
+          tree.assign_parallel(input.begin(), input.end(), threads, nodeSize == 7 ? 0.6 : 1.0);
+          assert(std::equal(tree.begin(), tree.end(), reference.begin(), reference.end()));
+          assert(std::equal(tree.rbegin(), tree.rend(), reference.rbegin(), reference.rend()));
+
+          //The built tree is an ordinary btree which keeps its balance through later changes
+          for (int i = 0; i < 2000; ++i) {
+            int value = static_cast<int>(gen() % 16000);
+            if (i % 2 == 0)
+              assert(tree.insert(value).second == reference.insert(value).second);
+            else
+              assert(tree.erase(value) == reference.erase(value));
+          }
+          assert(std::equal(tree.begin(), tree.end(), reference.begin(), reference.end()));
+
+          btree_multiset<int> repeated(nodeSize);
+          repeated.assign_parallel(input.begin(), input.end(), threads);
+          multiset<int> repeats(input.begin(), input.end());
+          assert(std::equal(repeated.begin(), repeated.end(), repeats.begin(), repeats.end()));
+
+          //Ranges are consecutive and hold every element once
+          for (size_t pieces : {1, 2, 5, 64, 100000}) {
+            auto ranges = tree.split(pieces);
+            assert(ranges.size() >= 1 && ranges.size() <= pieces);
+
+            auto it = tree.cbegin();
+            for (const auto& range : ranges) {
+              assert(range.begin() == it);
+              it = range.end();
+            }
+            assert(it == tree.cend());
+          }
+
+          std::atomic<long> sum(0);
+          std::atomic<size_t> visited(0);
+          parallel_for_each(tree, [&sum, &visited](int value) { sum += value; ++visited; }, threads);
+          assert(visited == reference.size() && sum == std::accumulate(reference.begin(), reference.end(), 0L));
+        }
+      }
+
+      //Maps keep the mapped value of the first of each key
+      vector<pair<int, int> > entries;
+      std::map<int, int> firsts;
+      for (int i = 0; i < 5000; ++i) {
+        entries.emplace_back(static_cast<int>(gen() % 3000), i);
+        firsts.insert(entries.back());
+      }
+
+      btree_map<int, int> map(5);
+      map.assign_parallel(entries.begin(), entries.end(), 4);
+      assert(map.size() == firsts.size());
+      for (const auto& entry : firsts)
+        assert(map.at(entry.first) == entry.second);
+
+      //Nothing to build or split in an empty tree
+      vector<string> none;
+      btree<string> words(4);
+      words.insert("word");
+      words.assign_parallel(none.begin(), none.end(), 2);
+      assert(words.begin() == words.end() && words.split(4).empty());
+      parallel_for_each(words, [](const string&) { assert(false); }, 2);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /*
+  * Test 25 - Size and order statistics
+  * Testing: size, rank, nth and iterator arithmetic against a sorted vector as elements are inserted, erased and loaded, in sets, multisets and maps
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      std::mt19937 gen(25);
+
+      for (size_t nodeSize : {2, 3, 5, 40}) {
+        btree_multiset<int> tree(nodeSize);
+        multiset<int> reference;
+        assert(tree.size() == 0 && tree.empty() && tree.nth(0) == tree.end() && tree.rank(1) == 0);
+
+        for (int round = 0; round < 6; ++round) {
+          for (int i = 0; i < 1500; ++i) {
+            int value = static_cast<int>(gen() % 400);
+
+            if (i % 3 == 2) {
+              assert(tree.erase(value) == reference.erase(value));
+            }
+            else {
+              tree.insert(value);
+              reference.insert(value);
+            }
+          }
+
+          //Erase a run of elements found by index
+          size_t from = gen() % (reference.size() + 1);
+          size_t to = std::min(reference.size(), from + gen() % 50);
+          tree.erase(tree.nth(from), tree.nth(to));
+          reference.erase(std::next(reference.begin(), from), std::next(reference.begin(), to));
+
+          //Reload from time to time, the loaded nodes counting their elements as inserted ones do
+          if (round == 2) {
+            vector<int> sorted(reference.begin(), reference.end());
+            tree.assign_sorted(sorted.begin(), sorted.end(), 0.5);
+          }
+          else if (round == 4) {
+            tree.assign_parallel(reference.rbegin(), reference.rend(), 2);
+          }
+
+          vector<int> sorted(reference.begin(), reference.end());
+          const btree_multiset<int>& view = tree;
+          assert(tree.size() == sorted.size() && !tree.empty());
+
+          for (size_t i = 0; i <= sorted.size(); ++i) {
+            btree_multiset<int>::iterator it = tree.nth(i);
+            assert(i == sorted.size() ? it == tree.end() : *it == sorted[i]);
+            assert(static_cast<size_t>(it - tree.begin()) == i && tree.begin() + i == it && tree.end() - (sorted.size() - i) == it);
+            assert(view.nth(i) == view.cbegin() + i && static_cast<size_t>(view.cend() - view.nth(i)) == sorted.size() - i);
+          }
+
+          for (int value = -1; value <= 401; ++value) {
+            assert(tree.rank(value) == static_cast<size_t>(std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin()));
+          }
+
+          //Jumps in both directions land where stepping would
+          btree_multiset<int>::const_iterator walker = view.cbegin();
+          walker += sorted.size() / 2;
+          walker -= sorted.size() / 4;
+          assert(walker - view.cbegin() == static_cast<ptrdiff_t>(sorted.size() / 2 - sorted.size() / 4));
+        }
+
+        //Copies and moves keep their counts
+        btree_multiset<int> copy(tree);
+        btree_multiset<int> moved(std::move(tree));
+        assert(copy.size() == reference.size() && moved.size() == reference.size() && tree.size() == 0);
+        copy.clear();
+        assert(copy.empty() && copy.begin() + 0 == copy.end());
+      }
+
+      //Percentiles of a map by index
+      btree_map<int, string> scores(4);
+      for (int i = 0; i < 1000; ++i)
+        scores[(i * 7919) % 1000] = std::to_string(i);
+
+      assert(scores.size() == 1000);
+      assert(scores.nth(500)->first == 500 && scores.nth(990)->first == 990 && scores.rank(250) == 250);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /**
+  * Test 26 - Structural statistics
+  * Testing: stats on empty, inserted and loaded trees against the size, height and node capacity, and resetting the counters
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      btree<int> empty(5);
+      btree_stats shape = empty.stats();
+
+      //The root is held even when empty, so it still counts as a node
+      assert(shape.size == 0 && shape.height == 0 && shape.nodes == 1 && shape.leaves == 1 && shape.fill == 0);
+
+      for (size_t nodeSize : {2, 5, 40}) {
+        btree<int> tree(nodeSize);
+        for (int i = 0; i < 5000; ++i)
+          tree.insert((i * 7919) % 5000);
+
+        shape = tree.stats();
+        assert(shape.size == 5000 && shape.height == tree.height() && shape.maxNodeElems == nodeSize);
+        assert(shape.leaves > 0 && shape.leaves < shape.nodes);
+        assert(shape.fill > 0 && shape.fill <= 1 && shape.leafFill > 0 && shape.leafFill <= 1);
+        assert(shape.nodeBytes > 0 && shape.poolBytes >= shape.nodeBytes / 2);
+
+        //Elements counted by fill are every element of the tree
+        assert(static_cast<size_t>(shape.fill * shape.nodes * nodeSize + 0.5) == 5000);
+
+        //Full leaves when loaded without room to spare
+        vector<int> sorted(tree.begin(), tree.end());
+        tree.assign_sorted(sorted.begin(), sorted.end());
+        btree_stats loaded = tree.stats();
+        assert(loaded.size == 5000 && loaded.nodes <= shape.nodes && loaded.leafFill >= shape.leafFill);
+      }
+
+      btree_counters& counters = btree_counters::local();
+      counters.comparisons = 3;
+      counters.reset();
+      assert(counters.comparisons == 0 && counters.splits == 0 && &counters == &btree_counters::local());
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /**
+  * Test 27 - Batched finds
+  * Testing: find_many and contains_many against find and contains, for sets, multisets and maps of several node sizes, empty trees and heterogeneous keys
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      std::mt19937 gen(27);
+
+      for (size_t nodeSize : {2, 3, 5, 40}) {
+        btree<int> tree(nodeSize);
+        btree_multiset<int> repeated(nodeSize);
+        vector<int> probes;
+
+        //Groups of keys of every size, some left incomplete
+        for (size_t batch : {0, 1, 15, 16, 17, 500}) {
+          probes.resize(batch);
+          for (int& probe : probes)
+            probe = static_cast<int>(gen() % 3000) - 100;
+
+          vector<btree<int>::iterator> found;
+          tree.find_many(probes.begin(), probes.end(), std::back_inserter(found));
+          assert(found.size() == batch);
+
+          vector<bool> present;
+          tree.contains_many(probes.begin(), probes.end(), std::back_inserter(present));
+
+          for (size_t i = 0; i < batch; ++i)
+            assert(found[i] == tree.find(probes[i]) && present[i] == tree.contains(probes[i]));
+
+          //The first of equivalent elements, wherever they lie
+          vector<btree_multiset<int>::const_iterator> first(batch);
+          const btree_multiset<int>& view = repeated;
+          assert(view.find_many(probes.begin(), probes.end(), first.begin()) == first.end());
+
+          for (size_t i = 0; i < batch; ++i)
+            assert(first[i] == view.find(probes[i]) && (first[i] == view.end() || first[i] == view.lower_bound(probes[i])));
+
+          for (int i = 0; i < 1000; ++i) {
+            int value = static_cast<int>(gen() % 2000);
+            tree.insert(value);
+            repeated.insert(value % 300);
+          }
+        }
+      }
+
+      btree_map<string, int, std::less<> > counts(3);
+      for (int i = 0; i < 200; ++i)
+        counts["key" + std::to_string(i)] = i;
+
+      std::string_view wanted[] = {"key7", "key", "key199", "key200", "key10"};
+      vector<btree_map<string, int, std::less<> >::iterator> hits(5);
+      counts.find_many(std::begin(wanted), std::end(wanted), hits.begin());
+      assert(hits[0]->second == 7 && hits[1] == counts.end() && hits[2]->second == 199 && hits[3] == counts.end());
+
+      hits[4]->second = -10;
+      assert(counts.at("key10") == -10);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
+  /**
+  * Test 28 - Batch insertion
+  * Testing: insert_batch of sorted, unsorted and repeated batches against std::set, std::multiset and std::map, returned counts, subtree sizes and later erasure
+  *
+  */
+  {
+    try {
+      cout << "Test " << ++testNum << ": ";
+
+      std::mt19937 gen(28);
+
+      for (size_t nodeSize : {2, 3, 5, 40}) {
+        btree<int> tree(nodeSize);
+        btree_multiset<int> repeated(nodeSize);
+        btree_map<int, int> firsts(nodeSize);
+        set<int> reference;
+        multiset<int> repeats;
+        map<int, int> mapped;
+
+        //Batches dense and sparse against the tree, from a lone value to many per leaf
+        for (size_t batch : {300, 0, 1, 7, 2000, 50, 1}) {
+          vector<int> values(batch);
+          for (int& value : values)
+            value = static_cast<int>(gen() % 4000);
+
+          if (batch % 2 == 0)
+            std::sort(values.begin(), values.end());
+
+          size_t before = reference.size();
+          reference.insert(values.begin(), values.end());
+          assert(tree.insert_batch(values.begin(), values.end()) == reference.size() - before);
+          assert(std::equal(tree.begin(), tree.end(), reference.begin(), reference.end()));
+
+          repeats.insert(values.begin(), values.end());
+          assert(repeated.insert_batch(values.begin(), values.end()) == batch);
+          assert(std::equal(repeated.begin(), repeated.end(), repeats.begin(), repeats.end()));
+
+          //Present keys keep their values, and of equivalent keys in the batch the first is kept
+          vector<pair<int, int> > pairs;
+          for (size_t i = 0; i < batch; ++i)
+            pairs.emplace_back(values[i], static_cast<int>(i));
+
+          mapped.insert(pairs.begin(), pairs.end());
+          firsts.insert_batch(pairs.begin(), pairs.end());
+          assert(firsts.size() == mapped.size());
+          for (const auto& entry : mapped)
+            assert(firsts.at(entry.first) == entry.second);
+
+          for (size_t i = 0; i <= reference.size(); i += 37)
+            assert(tree.nth(i) == tree.begin() + i);
+
+          for (int i = 0; i < 200; ++i) {
+            int value = static_cast<int>(gen() % 4000);
+            assert(tree.erase(value) == reference.erase(value));
+          }
+        }
+
+        assert(tree.size() == reference.size() && repeated.size() == repeats.size());
+      }
+
+      //Ascending batches fill leaves completely rather than splitting them in half
+      btree<int> ingest(10);
+      vector<int> ascending(1000);
+      std::iota(ascending.begin(), ascending.end(), 0);
+      ingest.insert(-1);
+
+      for (size_t i = 0; i < ascending.size(); i += 100)
+        assert(ingest.insert_batch(ascending.begin() + i, ascending.begin() + i + 100) == 100);
+
+      assert(ingest.size() == 1001 && *ingest.nth(500) == 499 && ingest.stats().leafFill > 0.9);
+
+      cout << "Passed!" << endl;
+    }
+    catch (exception&) {
+      cout << "FAILED!";
+      exit(1);
+    }
+  }
   
   //End, capture input
   cin.ignore(2);
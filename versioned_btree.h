@@ -0,0 +1,286 @@
+/**
+ * The versioned_btree is a B+-tree holding an ordered set of unique
+ * elements, from which readers take snapshots: stable, read only views
+ * of the tree as it was when each was taken, which writers never block
+ * and which never block writers.
+ *
+ * Nodes are never modified once published. A write copies the nodes on
+ * its path from the root down to the leaf it changes (and any sibling
+ * it splits, borrows from or merges with) and publishes the new root
+ * atomically, so every earlier version stays intact, sharing all its
+ * other nodes with the new one. Taking a snapshot pins the current
+ * epoch (see btree_epoch.h) and reads the current root: O(1), with no
+ * locks, however large the tree. Searches and iteration on a snapshot
+ * read its nodes without any synchronisation at all.
+ *
+ * Nodes a write replaces are retired with the epoch it publishes, and
+ * freed by a later write once no snapshot old enough to reach them is
+ * left. A long lived snapshot therefore holds on to the nodes of its
+ * version that have since been replaced, but nothing more.
+ *
+ * Writers are serialised with each other by a mutex. Any number of
+ * threads may take and use snapshots while they write. Every snapshot
+ * must be destroyed before its tree.
+ */
+
+#ifndef VERSIONED_BTREE_H
+#define VERSIONED_BTREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//Include our nodes, iterators, epochs and node searches
+#include "btree_node.h"
+#include "btree_epoch.h"
+#include "btree_search.h"
+#include "versioned_iterator.h"
+
+template <typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>,
+          size_t Fanout = btree_default_fanout<T>::value> class versioned_btree;
+
+/*
+* A read only view of a versioned_btree as it was when the snapshot was taken. It keeps its version's nodes
+* alive until it is destroyed or assigned over, and may be used from any thread.
+*/
+template <typename T, typename Compare, typename Alloc, size_t Fanout>
+class versioned_btree_snapshot {
+ public:
+  /** Iterator type definitions **/
+
+  //Snapshots are read only, so both iterator types are the same
+  typedef versioned_iterator<T, Fanout> iterator;
+  typedef versioned_iterator<T, Fanout> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  /**
+   * Move constructor
+   * Takes over the pin of original, which is left empty.
+   *
+   * @param original an rvalue reference to a snapshot
+   */
+  versioned_btree_snapshot(versioned_btree_snapshot<T, Compare, Alloc, Fanout>&& original);
+
+  /**
+   * Move assignment
+   * Releases our pin and takes over that of rhs, which is left empty.
+   *
+   * @param rhs an rvalue reference to a snapshot
+   */
+  versioned_btree_snapshot<T, Compare, Alloc, Fanout>& operator=(versioned_btree_snapshot<T, Compare, Alloc, Fanout>&& rhs);
+
+  //Each snapshot holds its own pin, take another snapshot instead of copying one
+  versioned_btree_snapshot(const versioned_btree_snapshot<T, Compare, Alloc, Fanout>&) = delete;
+  versioned_btree_snapshot<T, Compare, Alloc, Fanout>& operator=(const versioned_btree_snapshot<T, Compare, Alloc, Fanout>&) = delete;
+
+  //begin() and end(), both O(log n) as they descend to the first and last leaves
+  const_iterator begin() const;
+  const_iterator end() const;
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  /**
+    * Returns an iterator to the matching element, or end()
+    * if the element could not be found.
+    */
+  const_iterator find(const T& elem) const;
+
+  /**
+    * Returns whether an element equivalent to elem is present.
+    */
+  bool contains(const T& elem) const;
+
+  /**
+    * Returns an iterator to the first element not ordered before elem,
+    * or end() if every element is ordered before it.
+    */
+  const_iterator lower_bound(const T& elem) const { return findBound(elem, false); }
+
+  /**
+    * Returns an iterator to the first element ordered after elem,
+    * or end() if no element is ordered after it.
+    */
+  const_iterator upper_bound(const T& elem) const { return findBound(elem, true); }
+
+  /**
+    * Returns the number of elements in the snapshot.
+    */
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  /**
+    * Destructor
+    * Unpins the snapshot's epoch, so a later write may free its replaced nodes.
+    */
+  ~versioned_btree_snapshot();
+
+ private:
+  friend class versioned_btree<T, Compare, Alloc, Fanout>;
+
+  typedef versioned_node<T, Fanout> Node;
+  typedef versioned_inner<T, Fanout> Inner;
+
+  versioned_btree_snapshot(btree_epoch *epochs, btree_epoch::slot *pin, const Node *root, size_t count, const Compare& comp)
+    : epochs(epochs), pin(pin), root(root), count(count), comp(comp) {}
+
+  //The tree's epochs and our pin, null once moved from
+  btree_epoch *epochs;
+  btree_epoch::slot *pin;
+
+  const Node *root;
+  size_t count;
+  Compare comp;
+
+  //Descend to the leaf holding a lower or upper bound, recording the path
+  const_iterator findBound(const T& elem, bool upper) const;
+
+  //An iterator at the first or last leaf
+  const_iterator edge(bool last) const;
+};
+
+/*
+ * T is the element type, ordered by Compare. All node memory comes from a pool which takes its slabs from an
+ * allocator of type Alloc. Every node holds up to Fanout keys, by default eight cache lines of them.
+*/
+template <typename T, typename Compare, typename Alloc, size_t Fanout>
+class versioned_btree {
+  static_assert(Fanout >= 3, "a node must be able to hold at least three elements");
+
+ public:
+  typedef versioned_btree_snapshot<T, Compare, Alloc, Fanout> snapshot_type;
+
+  /**
+   * Constructs an empty versioned_btree.
+   *
+   * @param comp the ordering used to compare elements
+   * @param alloc the allocator node slabs are obtained from
+   */
+  versioned_btree(const Compare& comp = Compare(), const Alloc& alloc = Alloc());
+
+  //Snapshots refer back to their tree, so it stays in place
+  versioned_btree(const versioned_btree&) = delete;
+  versioned_btree& operator=(const versioned_btree&) = delete;
+
+  /**
+    * Returns a snapshot of the tree as it is now. Any thread may take
+    * a snapshot at any time, without waiting for writers.
+    *
+    * Complexity: O(1)
+    */
+  snapshot_type snapshot() const;
+
+  /**
+    * Inserts elem if no equivalent element is present, publishing a new
+    * version of the tree. Snapshots already taken are unaffected.
+    *
+    * @param elem the element to insert.
+    * @return whether elem was inserted.
+    */
+  bool insert(const T& elem);
+
+  /**
+    * Removes the element equivalent to elem, if present, publishing a
+    * new version of the tree. Snapshots already taken are unaffected.
+    *
+    * @param elem the element to remove.
+    * @return whether an element was removed.
+    */
+  bool erase(const T& elem);
+
+  /**
+    * Returns the number of elements in the current version.
+    */
+  size_t size() const { return count.load(std::memory_order_relaxed); }
+
+  /**
+    * Returns the allocator node slabs are obtained from.
+    */
+  Alloc get_allocator() const { return static_cast<const btree_alloc_pool<Alloc>&>(*pool).get_allocator(); }
+
+  /**
+    * Destructor
+    * Destroys every node of the current version and any still retired. No snapshot may be left.
+    */
+  ~versioned_btree();
+
+ private:
+  typedef versioned_node<T, Fanout> Node;
+  typedef versioned_inner<T, Fanout> Inner;
+
+  //A published version of the tree, replaced as a whole by each write
+  struct version {
+    const Node *root;
+    size_t size;
+  };
+
+  //The result of rebuilding a node, which becomes two nodes and a separator between them when it overflows
+  struct split {
+    const Node *left;
+    const Node *right;
+    T separator;
+  };
+
+  //Nodes and elements are removed until at most half full
+  static constexpr size_t minElements = Fanout / 2;
+
+  //Ordering of elements
+  Compare comp;
+
+  //Serialises writers, which are the only ones to allocate or free nodes
+  std::mutex writer;
+
+  //Pool every node is allocated from. Declared before the nodes so it outlives them.
+  std::unique_ptr<btree_pool> pool;
+
+  //Pins of the snapshots reading each version
+  mutable btree_epoch epochs;
+
+  //The latest version, and its size for size()
+  std::atomic<version*> current;
+  std::atomic<size_t> count;
+
+  //Nodes and versions unlinked by each write, tagged with the epoch it published
+  std::deque<std::pair<uint64_t, const Node*> > retiredNodes;
+  std::deque<std::pair<uint64_t, version*> > retiredVersions;
+
+  //Published nodes replaced during the current write
+  std::vector<const Node*> replaced;
+
+  //Copy the path down to elem with elem inserted, or return false if it is present
+  bool insertInto(const Node *node, const T& elem, split& result);
+
+  //Copy the path down to elem with elem removed, or return false if it is absent
+  bool eraseFrom(const Node *node, const T& elem, const Node*& result);
+
+  //Build one node from keys, or two around a separator when there are more than fit in one
+  void buildLeaves(const T *keys, size_t n, split& result);
+  void buildInners(const T *keys, size_t n, const Node *const *children, split& result);
+
+  //Publish a new version, retire what it replaced and free whatever no snapshot can reach
+  void publish(const Node *root, size_t size);
+  void reclaim();
+
+  //Node memory management
+  const Node* newLeaf(const T *keys, size_t n);
+  const Node* newInner(const T *keys, size_t n, const Node *const *children);
+  void deleteNode(const Node *node);
+  void deleteTree(const Node *node);
+};
+
+#include "versioned_btree.tem"
+
+#endif
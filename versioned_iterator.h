@@ -0,0 +1,80 @@
+#ifndef VERSIONED_ITERATOR_H
+#define VERSIONED_ITERATOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "btree_node.h"
+
+/**
+ * versioned_iterator implementation.
+ *
+ * Will allow in-order (from lowest to highest) traversal through a snapshot of a versioned_btree.
+ * Nodes are shared between versions and so have no parent or sibling links. The iterator instead keeps
+ * the path it took down from the root, holding the child followed at each internal node and the slot
+ * within the leaf at the bottom, and climbs back up that path to step between leaves.
+ * The end() position is the slot one past the last element of the last leaf.
+ *
+*/
+
+template <typename T, typename Compare, typename Alloc, size_t Fanout> class versioned_btree_snapshot;
+
+template <typename T, size_t Fanout>
+class versioned_iterator {
+public:
+  template <typename, typename, typename, size_t> friend class versioned_btree_snapshot;
+
+  typedef ptrdiff_t difference_type;
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef const T* pointer;
+  typedef const T& reference;
+
+  bool operator==(const versioned_iterator<T, Fanout>&) const;
+  bool operator!=(const versioned_iterator<T, Fanout>& other) const { return !operator==(other); }
+
+  reference operator*() const { return path[depth - 1].node->keys[path[depth - 1].pos]; }
+  pointer operator->() const { return &(operator*()); }
+  versioned_iterator<T, Fanout>& operator++(); //preinc
+  versioned_iterator<T, Fanout> operator++(int); //postinc
+  versioned_iterator<T, Fanout>& operator--(); //predec
+  versioned_iterator<T, Fanout> operator--(int); //postdec
+
+  //Constructors, copying and assignment are left implicit so iterators stay trivially copyable
+  versioned_iterator() : depth(0) {}
+
+private:
+  typedef versioned_node<T, Fanout> Node;
+  typedef versioned_inner<T, Fanout> Inner;
+
+  //Every internal node but the root has at least Fanout / 2 + 1 children, which bounds the height of any tree of up to 2^64 elements
+  static constexpr size_t maxHeight() {
+    size_t bits = 0;
+    for (size_t children = Fanout / 2 + 1; children > 1; children >>= 1)
+      ++bits;
+
+    return 1 + (64 + bits - 1) / bits;
+  }
+
+  //A node on the path with the child followed from it, or for the leaf the slot of the element
+  struct frame {
+    const Node *node;
+    size_t pos;
+  };
+
+  frame path[maxHeight()];
+  size_t depth;
+
+  //Descend from the last node of the path to its first (or last) leaf, following the first (or last) child of each node
+  void descend(bool last);
+
+  //From the end of the leaf, move onto the first element of the next leaf, if there is one
+  void nextLeaf();
+};
+
+static_assert(std::is_trivially_copyable<versioned_iterator<int, 4> >::value, "versioned_iterator must be trivially copyable");
+
+#include "versioned_iterator.tem"
+
+#endif